@@ -0,0 +1,176 @@
+#pragma once
+#include "Matrix.hpp"
+#include "Decomposition.hpp"
+#include "Tuning.hpp"
+#include "Backend.hpp"
+
+#include <chrono>
+#include <limits>
+#include <initializer_list>
+
+namespace distmat
+{
+namespace tuning
+{
+
+struct AutotuneOptions {
+  Index gemmSize = 384;          ///< order of the square products timed for the GEMM tiles
+  Index crossoverMaxSize = 256;  ///< largest order tried for `gemmBlockedMinSize`
+  Index transposeSize = 2048;    ///< order of the transposed matrix
+  Index decompSize = 768;        ///< order of the LU decomposition timed for the panel width
+  Index coeffWiseSize = Index(1) << 22;  ///< coefficients of the `+=` timed for the grains
+  Index gevmSize = 2048;         ///< order of the matrix of the timed vector-matrix product
+  int repeats = 3;               ///< every candidate is timed this many times, the best run counts
+  bool save = true;              ///< save the winners to `path`
+  std::filesystem::path path = profilePath();
+};
+
+namespace detail {
+  template<typename F>
+  double bestTime(int repeats, F&& f)
+  {
+    double best = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < std::max(repeats, 1); ++i) {
+      const auto start = std::chrono::steady_clock::now();
+      f();
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      best = std::min(best, elapsed.count());
+    }
+    return best;
+  }
+
+  /// Set `params().*field` to the fastest of `candidates` for `f`.
+  template<typename F>
+  void tuneField(Index Params::* field, std::initializer_list<Index> candidates, int repeats, F&& f)
+  {
+    double best = std::numeric_limits<double>::infinity();
+    Index winner = params().*field;
+    for (auto candidate : candidates) {
+      params().*field = candidate;
+      const double time = bestTime(repeats, f);
+      if (time < best) {
+        best = time;
+        winner = candidate;
+      }
+    }
+    params().*field = winner;
+  }
+
+  inline Matrix<double> testMatrix(Index rows, Index cols)
+  {
+    Matrix<double> A(rows, cols);
+    for (Index i = 0; i < A.size(); ++i) {
+      A[i] = double((i * 7919) % 1000) / 1000.0 - 0.5;
+    }
+    for (Index i = 0; i < std::min(rows, cols); ++i) {
+      A(i, i) += double(rows);  // keep the LU well conditioned
+    }
+    return A;
+  }
+} // namespace detail
+
+/// \brief Measure the kernel parameters on the host CPU.
+/// Every parameter is tuned in turn with the others fixed to their current
+/// values, the winners are stored in `params()` and, if `options.save`, in the
+/// profile file that `params()` loads in later runs. Takes a few seconds with
+/// the default options.
+inline Params autotune(const AutotuneOptions& options = {})
+{
+  const int repeats = options.repeats;
+  // the built-in kernels are tuned, not the CBLAS backend
+  const bool useCblas = backend::useCblas();
+  backend::setUseCblas(false);
+
+  {
+    const Index n = options.gemmSize;
+    const auto A = detail::testMatrix(n, n);
+    const auto B = detail::testMatrix(n, n);
+    auto gemm = [&] { auto C = A * B; };
+    params().gemmBlockedMinSize = 1;
+    detail::tuneField(&Params::gemmBlockCols, {64, 128, 256, 512, 1024}, repeats, gemm);
+    detail::tuneField(&Params::gemmBlockInner, {32, 64, 128, 256, 512}, repeats, gemm);
+    detail::tuneField(&Params::gemmBlockRows, {8, 16, 32, 64, 128}, repeats, gemm);
+    detail::tuneField(&Params::parallelMinWork, {Index(1) << 12, Index(1) << 15, Index(1) << 18, Index(1) << 21}, repeats, gemm);
+  }
+
+  {
+    // smallest order where the blocked multiplication beats the plain loop,
+    // or past the tried orders if it never does, so that large products
+    // keep the blocked (and parallel) kernel
+    Index crossover = options.crossoverMaxSize + 1;
+    for (Index n : {8, 16, 32, 48, 64, 96, 128, 192, 256}) {
+      if (n > options.crossoverMaxSize) {
+        break;
+      }
+      const auto A = detail::testMatrix(n, n);
+      auto gemm = [&] { auto C = A * A; };
+      const int reps = std::max<int>(repeats, int(4096 / n));
+      params().gemmBlockedMinSize = n;
+      const double blocked = detail::bestTime(reps, gemm);
+      params().gemmBlockedMinSize = n + 1;
+      const double plain = detail::bestTime(reps, gemm);
+      if (blocked < plain) {
+        crossover = n;
+        break;
+      }
+    }
+    params().gemmBlockedMinSize = crossover;
+  }
+
+  {
+    const auto A = detail::testMatrix(options.transposeSize, options.transposeSize);
+    detail::tuneField(&Params::transposeBlock, {8, 16, 32, 64, 128}, repeats, [&] { auto T = A.transpose().eval(); });
+  }
+
+  {
+    const auto A = detail::testMatrix(options.decompSize, options.decompSize);
+    detail::tuneField(&Params::decompBlockSize, {16, 32, 64, 128, 256}, repeats, [&] { PartialPivLU<Matrix<double>> lu(A); });
+  }
+
+  {
+    const auto B = detail::testMatrix(1, options.coeffWiseSize);
+    auto A = B;
+    detail::tuneField(&Params::coeffWiseGrain, {Index(1) << 12, Index(1) << 14, Index(1) << 16, Index(1) << 18, Index(1) << 20},
+      repeats, [&] { A += B; });
+  }
+
+  {
+    const auto A = detail::testMatrix(options.gevmSize, options.gevmSize);
+    const auto x = detail::testMatrix(1, options.gevmSize);
+    auto y = x;
+    detail::tuneField(&Params::gevmBlockCols, {1024, 2048, 4096, 8192, 16384}, repeats, [&] { multiplyRowVector(x, A, y); });
+  }
+
+  if constexpr (backend::hasCblas) {
+    // smallest product that CBLAS computes faster than the built-in kernels
+    Index crossover = options.crossoverMaxSize + 1;
+    backend::setUseCblas(true);
+    for (Index n : {8, 16, 32, 48, 64, 96, 128, 192, 256}) {
+      if (n > options.crossoverMaxSize) {
+        break;
+      }
+      const auto A = detail::testMatrix(n, n);
+      auto gemm = [&] { auto C = A * A; };
+      const int reps = std::max<int>(repeats, int(4096 / n));
+      params().blasMinWork = n * n * n;
+      const double blas = detail::bestTime(reps, gemm);
+      params().blasMinWork = n * n * n + 1;
+      const double builtIn = detail::bestTime(reps, gemm);
+      if (blas < builtIn) {
+        crossover = n;
+        break;
+      }
+    }
+    params().blasMinWork = crossover * crossover * crossover;
+  }
+
+  backend::setUseCblas(useCblas);
+
+  if (options.save && !options.path.empty()) {
+    save(params(), options.path);
+  }
+  return params();
+}
+
+} // namespace tuning
+} // namespace distmat
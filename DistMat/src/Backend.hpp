@@ -0,0 +1,172 @@
+#pragma once
+#include "Type.hpp"
+#include "Tuning.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <type_traits>
+
+#ifdef DISTMAT_USE_CBLAS
+#include <cblas.h>
+#endif
+
+namespace distmat
+{
+namespace backend
+{
+
+/// Whether DistMat is built against a CBLAS such as OpenBLAS or BLIS, which
+/// CMake detects when the option `DISTMAT_USE_BLAS` is on.
+#ifdef DISTMAT_USE_CBLAS
+inline constexpr bool hasCblas = true;
+#else
+inline constexpr bool hasCblas = false;
+#endif
+
+namespace detail {
+  inline std::atomic<bool>& useCblas()
+  {
+    static std::atomic<bool> use{hasCblas};
+    return use;
+  }
+} // namespace detail
+
+/// Whether the products and the coefficient-wise operations are routed to
+/// CBLAS, on by default if it is available. Turning it off runs the built-in
+/// kernels, e.g. to compare them.
+inline bool useCblas() { return hasCblas && detail::useCblas().load(std::memory_order_relaxed); }
+inline void setUseCblas(bool use) { detail::useCblas().store(use, std::memory_order_relaxed); }
+
+/// Matrices CBLAS can work on: `float` or `double` coefficients in contiguous
+/// row major storage exposed by `data()`. Shapes with a fixed dimension and
+/// inline storages such as `SmallStorage` are left to the built-in kernels,
+/// which are made for them and don't pay for a library call.
+template<typename T>
+  concept BlasMatrix = (same_as<typename T::scalar_type, float> || same_as<typename T::scalar_type, double>)
+    && requires (const T& mat) { { mat.data() } -> same_as<const typename T::scalar_type*>; }
+    && T::rowsAtCompileTime == -1 && T::colsAtCompileTime == -1
+    && !requires { T::storage_type::inlineSize; };
+
+/// Whether all of `Ts` can be passed to CBLAS together.
+template<typename T, typename... Ts>
+  concept CanUseCblas = hasCblas && BlasMatrix<T> && (BlasMatrix<Ts> && ...)
+    && (same_as<typename T::scalar_type, typename Ts::scalar_type> && ...);
+
+namespace detail {
+  inline bool fitsInt(Index n) { return n <= Index(INT_MAX); }
+  /// Whether `work` multiply-adds are worth a library call, see `tuning::Params::blasMinWork`.
+  inline bool isWorthCall(Index work) { return work >= tuning::params().blasMinWork; }
+} // namespace detail
+
+// The functions below are only called when `CanUseCblas` holds and
+// `useCblas()`, they return false if the operands are too large for the
+// `int` sizes of CBLAS or too small to pay for the call, the caller then runs
+// its own kernel.
+
+/// `C = alpha * A * B + beta * C`
+template<typename Scalar>
+bool gemm(const auto& A, const auto& B, auto& C, Scalar alpha, Scalar beta)
+{
+#ifdef DISTMAT_USE_CBLAS
+  const Index m = A.rows();
+  const Index k = A.cols();
+  const Index n = B.cols();
+  if (!detail::isWorthCall(m * n * k) || !detail::fitsInt(A.size()) || !detail::fitsInt(B.size()) || !detail::fitsInt(C.size())) {
+    return false;
+  }
+  const int lda = int(std::max<Index>(k, 1));
+  const int ldb = int(std::max<Index>(n, 1));
+  if constexpr (same_as<Scalar, double>) {
+    cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, int(m), int(n), int(k),
+      alpha, A.data(), lda, B.data(), ldb, beta, C.data(), ldb);
+  } else {
+    cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, int(m), int(n), int(k),
+      alpha, A.data(), lda, B.data(), ldb, beta, C.data(), ldb);
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+/// `y = alpha * op(A) * x + beta * y`, where `op(A)` is `A^T` for `isTransposed`.
+/// `x` and `y` are contiguous vectors.
+template<typename Scalar>
+bool gemv(const auto& A, const auto& x, auto& y, Scalar alpha, Scalar beta, bool isTransposed)
+{
+#ifdef DISTMAT_USE_CBLAS
+  if (!detail::isWorthCall(A.size()) || !detail::fitsInt(A.size())) {
+    return false;
+  }
+  const auto trans = isTransposed ? CblasTrans : CblasNoTrans;
+  const int lda = int(std::max<Index>(A.cols(), 1));
+  if constexpr (same_as<Scalar, double>) {
+    cblas_dgemv(CblasRowMajor, trans, int(A.rows()), int(A.cols()), alpha, A.data(), lda, x.data(), 1, beta, y.data(), 1);
+  } else {
+    cblas_sgemv(CblasRowMajor, trans, int(A.rows()), int(A.cols()), alpha, A.data(), lda, x.data(), 1, beta, y.data(), 1);
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+/// `dst = src`
+inline bool copy(const auto& src, auto& dst)
+{
+#ifdef DISTMAT_USE_CBLAS
+  if (!detail::isWorthCall(src.size()) || !detail::fitsInt(src.size())) {
+    return false;
+  }
+  if constexpr (same_as<std::remove_cvref_t<decltype(*src.data())>, double>) {
+    cblas_dcopy(int(src.size()), src.data(), 1, dst.data(), 1);
+  } else {
+    cblas_scopy(int(src.size()), src.data(), 1, dst.data(), 1);
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+/// `dst += alpha * src`
+template<typename Scalar>
+bool axpy(Scalar alpha, const auto& src, auto& dst)
+{
+#ifdef DISTMAT_USE_CBLAS
+  if (!detail::isWorthCall(src.size()) || !detail::fitsInt(src.size())) {
+    return false;
+  }
+  if constexpr (same_as<Scalar, double>) {
+    cblas_daxpy(int(src.size()), alpha, src.data(), 1, dst.data(), 1);
+  } else {
+    cblas_saxpy(int(src.size()), alpha, src.data(), 1, dst.data(), 1);
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+/// `dst *= alpha`
+template<typename Scalar>
+bool scal(Scalar alpha, auto& dst)
+{
+#ifdef DISTMAT_USE_CBLAS
+  if (!detail::isWorthCall(dst.size()) || !detail::fitsInt(dst.size())) {
+    return false;
+  }
+  if constexpr (same_as<Scalar, double>) {
+    cblas_dscal(int(dst.size()), alpha, dst.data(), 1);
+  } else {
+    cblas_sscal(int(dst.size()), alpha, dst.data(), 1);
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+} // namespace backend
+} // namespace distmat
@@ -0,0 +1,87 @@
+#pragma once
+#include "Type.hpp"
+
+#include <type_traits>
+
+namespace distmat
+{
+
+/// A rectangular view `mat[row:row+rows, col:col+cols]` into another matrix.
+/// It only provides `rows()`, `cols()` and `operator()`, which is all the
+/// kernels in `mul` need, so kernels written for whole matrices can be
+/// applied to sub-blocks without copying.
+template<typename MatrixType>
+class Block {
+public:
+  using scalar_type = typename std::remove_const_t<MatrixType>::scalar_type;
+  using reference = conditional_t<std::is_const_v<MatrixType>, const scalar_type&, scalar_type&>;
+
+  constexpr Block(MatrixType& mat, Index row, Index col, Index rows, Index cols)
+    : mat_(&mat), row_(row), col_(col), rows_(rows), cols_(cols)
+  {
+    assert(row + rows <= mat.rows() && col + cols <= mat.cols());
+  }
+
+  constexpr reference operator()(Index row, Index col) const
+  {
+    return (*mat_)(row_ + row, col_ + col);
+  }
+
+  constexpr Index rows() const { return rows_; }
+  constexpr Index cols() const { return cols_; }
+
+  constexpr Block block(Index row, Index col, Index rows, Index cols) const
+  {
+    assert(row + rows <= rows_ && col + cols <= cols_);
+    return Block(*mat_, row_ + row, col_ + col, rows, cols);
+  }
+
+private:
+  MatrixType* mat_;
+  Index row_;
+  Index col_;
+  Index rows_;
+  Index cols_;
+};
+
+template<typename MatrixType>
+constexpr Block<MatrixType> block(MatrixType& mat, Index row, Index col, Index rows, Index cols)
+{
+  return Block<MatrixType>(mat, row, col, rows, cols);
+}
+
+template<typename MatrixType>
+constexpr Block<MatrixType> block(MatrixType& mat)
+{
+  return Block<MatrixType>(mat, 0, 0, mat.rows(), mat.cols());
+}
+
+/// Transposed view of a `Block`, `t(i, j)` is `b(j, i)`.
+template<typename MatrixType>
+class Transposed {
+public:
+  using reference = typename Block<MatrixType>::reference;
+
+  constexpr explicit Transposed(Block<MatrixType> block) : block_(block) {}
+
+  constexpr reference operator()(Index row, Index col) const { return block_(col, row); }
+
+  constexpr Index rows() const { return block_.cols(); }
+  constexpr Index cols() const { return block_.rows(); }
+
+  constexpr Transposed block(Index row, Index col, Index rows, Index cols) const
+  {
+    return Transposed(block_.block(col, row, cols, rows));
+  }
+
+private:
+  Block<MatrixType> block_;
+};
+
+template<typename MatrixType>
+constexpr Transposed<MatrixType> transposed(Block<MatrixType> block)
+{
+  return Transposed<MatrixType>(block);
+}
+
+} // namespace distmat
@@ -0,0 +1,382 @@
+#pragma once
+#include "Matrix.hpp"
+#include "Block.hpp"
+#include "Parallel.hpp"
+#include "Error.hpp"
+
+#include <cmath>
+#include <future>
+#include <utility>
+
+namespace distmat
+{
+
+namespace decomp {
+
+/// Panel width of the blocked factorizations and triangular solves.
+inline Index defaultBlockSize() { return tuning::params().decompBlockSize; }
+
+/// Unblocked triangular solve on a diagonal block, see `triangularSolveInPlace`.
+template<Side side, UpLo uplo, Diag diag>
+void triangularSolveUnblocked(const auto& T, auto&& X)
+{
+  const Index n = T.rows();
+  if constexpr (side == Side::Left) {
+    // row oriented, so that the innermost loop walks a row of X
+    for (Index r = 0; r < n; ++r) {
+      const Index i = uplo == UpLo::Lower ? r : n - 1 - r;
+      const Index kBegin = uplo == UpLo::Lower ? 0 : i + 1;
+      const Index kEnd = uplo == UpLo::Lower ? i : n;
+      for (Index k = kBegin; k < kEnd; ++k) {
+        const auto t = T(i, k);
+        for (Index j = 0; j < X.cols(); ++j) {
+          X(i, j) -= t * X(k, j);
+        }
+      }
+      if constexpr (diag == Diag::NonUnit) {
+        const auto d = T(i, i);
+        for (Index j = 0; j < X.cols(); ++j) {
+          X(i, j) /= d;
+        }
+      }
+    }
+  } else {
+    for (Index i = 0; i < X.rows(); ++i) {
+      for (Index r = 0; r < n; ++r) {
+        const Index j = uplo == UpLo::Upper ? r : n - 1 - r;
+        const Index kBegin = uplo == UpLo::Upper ? 0 : j + 1;
+        const Index kEnd = uplo == UpLo::Upper ? j : n;
+        auto x = X(i, j);
+        for (Index k = kBegin; k < kEnd; ++k) {
+          x -= X(i, k) * T(k, j);
+        }
+        if constexpr (diag == Diag::NonUnit) {
+          x /= T(j, j);
+        }
+        X(i, j) = x;
+      }
+    }
+  }
+}
+
+/// Blocked triangular solve run by a single thread.
+template<Side side, UpLo uplo, Diag diag>
+void triangularSolveBlocked(const auto& T, auto X, Index blockSize)
+{
+  const Index n = T.rows();
+  // Process diagonal blocks in the order the substitution visits them, and
+  // push every solved block into the rest of X with the multiply kernel.
+  const bool forward = (side == Side::Left) == (uplo == UpLo::Lower);
+  for (Index step = 0; step < n; step += blockSize) {
+    const Index kw = std::min(blockSize, n - step);
+    const Index k0 = forward ? step : n - step - kw;
+    const Index k1 = k0 + kw;
+    const Index rBegin = forward ? k1 : 0;
+    const Index rEnd = forward ? n : k0;
+    if constexpr (side == Side::Left) {
+      auto Xk = X.block(k0, 0, kw, X.cols());
+      triangularSolveUnblocked<side, uplo, diag>(T.block(k0, k0, kw, kw), Xk);
+      if (rBegin < rEnd) {
+        mul::multiplyMatrixSubTo<Index>(T.block(rBegin, k0, rEnd - rBegin, kw), Xk,
+          X.block(rBegin, 0, rEnd - rBegin, X.cols()));
+      }
+    } else {
+      auto Xk = X.block(0, k0, X.rows(), kw);
+      triangularSolveUnblocked<side, uplo, diag>(T.block(k0, k0, kw, kw), Xk);
+      if (rBegin < rEnd) {
+        mul::multiplyMatrixSubTo<Index>(Xk, T.block(k0, rBegin, kw, rEnd - rBegin),
+          X.block(0, rBegin, X.rows(), rEnd - rBegin));
+      }
+    }
+  }
+}
+
+} // namespace decomp
+
+/// \brief Triangular solve with multiple right hand sides (TRSM), in place.
+/// `Side::Left` solves `T * X = B`, `Side::Right` solves `X * T = B`, where `B`
+/// is given in `X` and overwritten by the solution. Only the `uplo` triangle of
+/// `T` is read, and its diagonal is assumed to be one for `Diag::Unit`.
+/// Columns (left) or rows (right) of `X` are independent, so they are split
+/// among the worker threads, every thread running a blocked substitution.
+/// \param T a square matrix, `Block` or `Transposed` view
+/// \param X a matrix or `Block` view
+template<Side side, UpLo uplo, Diag diag = Diag::NonUnit>
+void triangularSolveInPlace(const auto& T, auto&& X, Index blockSize = decomp::defaultBlockSize())
+{
+  CHECK_SQUARE(T);
+  if constexpr (side == Side::Left) {
+    CHECK_MUL_DIM(T, X);
+  } else {
+    CHECK_MUL_DIM(X, T);
+  }
+  const auto TBlock = [&T] {
+    if constexpr (requires { T.block(0, 0, 0, 0); }) { return T; }
+    else { return block(T); }
+  }();
+  auto XBlock = [&X] {
+    if constexpr (requires { X.block(0, 0, 0, 0); }) { return X; }
+    else { return block(X); }
+  }();
+
+  const Index n = T.rows();
+  if constexpr (side == Side::Left) {
+    parallel::parallelFor(0, XBlock.cols(), parallel::grainFor(n * n), [&](Index lo, Index hi)
+    {
+      decomp::triangularSolveBlocked<side, uplo, diag>(TBlock, XBlock.block(0, lo, XBlock.rows(), hi - lo), blockSize);
+    });
+  } else {
+    parallel::parallelFor(0, XBlock.rows(), parallel::grainFor(n * n), [&](Index lo, Index hi)
+    {
+      decomp::triangularSolveBlocked<side, uplo, diag>(TBlock, XBlock.block(lo, 0, hi - lo, XBlock.cols()), blockSize);
+    });
+  }
+}
+
+/// \brief LU decomposition with partial pivoting, `P * A = L * U`.
+/// Right-looking blocked algorithm: every panel of `blockSize` columns is
+/// factorized unblocked, the rows of `U` right of it are obtained with TRSM and
+/// the trailing matrix is updated with the multiply kernel, split by rows among
+/// the worker threads. The next panel is factorized on its own thread while the
+/// rest of the trailing matrix is being updated (look-ahead).
+/// `L` (unit diagonal) and `U` are stored packed in `matrixLU()`.
+template<typename MatrixType>
+class PartialPivLU {
+public:
+  using Scalar = typename MatrixType::scalar_type;
+
+  explicit PartialPivLU(const MatrixType& A, Index blockSize = decomp::defaultBlockSize())
+    : lu_(A), pivots_(A.rows()), perm_(A.rows())
+  {
+    CHECK_SQUARE(A);
+    factorize(std::max<Index>(blockSize, 1));
+  }
+
+  const MatrixType& matrixLU() const { return lu_; }
+  /// Row `i` of `P * A` is row `permutation()[i]` of `A`.
+  const vector<Index>& permutation() const { return perm_; }
+
+  /// Solve `A * X = B`.
+  DISTMAT_MEM_TFUNC
+  OtherDerived solve(const MatrixBase<OtherDerived, Scalar>& B) const
+  {
+    CHECK_MUL_DIM(lu_, B.derived());
+    const auto& b = B.derived();
+    auto X = detail::makeMatrix<OtherDerived>(b.rows(), b.cols());
+    for (Index i = 0; i < X.rows(); ++i) {
+      for (Index j = 0; j < X.cols(); ++j) {
+        X(i, j) = b(perm_[i], j);
+      }
+    }
+    triangularSolveInPlace<Side::Left, UpLo::Lower, Diag::Unit>(lu_, X);
+    triangularSolveInPlace<Side::Left, UpLo::Upper, Diag::NonUnit>(lu_, X);
+    return X;
+  }
+
+private:
+  /// Unblocked LU of the columns `[k0, k1)`, rows `[k0, n)`. Row swaps are only
+  /// applied inside the panel, the caller applies them to the other columns.
+  void factorizePanel(Index k0, Index k1)
+  {
+    const Index n = lu_.rows();
+    for (Index c = k0; c < k1; ++c) {
+      Index p = c;
+      for (Index r = c + 1; r < n; ++r) {
+        if (std::abs(lu_(r, c)) > std::abs(lu_(p, c))) {
+          p = r;
+        }
+      }
+      if (lu_(p, c) == traits::scalar_traits<Scalar>::zero) {
+        throw std::runtime_error(ERROR_WHERE() + "\n\tError: matrix is singular");
+      }
+      pivots_[c] = p;
+      if (p != c) {
+        for (Index j = k0; j < k1; ++j) {
+          std::swap(lu_(c, j), lu_(p, j));
+        }
+      }
+      const auto pivot = lu_(c, c);
+      for (Index r = c + 1; r < n; ++r) {
+        lu_(r, c) /= pivot;
+        const auto l = lu_(r, c);
+        for (Index j = c + 1; j < k1; ++j) {
+          lu_(r, j) -= l * lu_(c, j);
+        }
+      }
+    }
+  }
+
+  /// `A[r, cBegin:cEnd] -= L[r, k0:k1] * U[k0:k1, cBegin:cEnd]` for rows `r >= k1`.
+  void updateTrailing(Index k0, Index k1, Index cBegin, Index cEnd)
+  {
+    const Index n = lu_.rows();
+    const Index kw = k1 - k0;
+    const Index cw = cEnd - cBegin;
+    parallel::parallelFor(k1, n, parallel::grainFor(kw * cw), [&](Index lo, Index hi)
+    {
+      mul::multiplyMatrixSubTo<Index>(block(lu_, lo, k0, hi - lo, kw),
+        block(lu_, k0, cBegin, kw, cw), block(lu_, lo, cBegin, hi - lo, cw));
+    });
+  }
+
+  void factorize(Index blockSize)
+  {
+    const Index n = lu_.rows();
+    if (n == 0) {
+      return;
+    }
+    factorizePanel(0, std::min(blockSize, n));
+    for (Index k0 = 0; k0 < n; k0 += blockSize) {
+      const Index k1 = std::min(k0 + blockSize, n);
+      // apply the panel's row swaps outside the panel
+      for (Index c = k0; c < k1; ++c) {
+        if (pivots_[c] != c) {
+          for (Index j = 0; j < k0; ++j) {
+            std::swap(lu_(c, j), lu_(pivots_[c], j));
+          }
+          for (Index j = k1; j < n; ++j) {
+            std::swap(lu_(c, j), lu_(pivots_[c], j));
+          }
+        }
+      }
+      if (k1 == n) {
+        break;
+      }
+      // U12 = L11^-1 * A12
+      triangularSolveInPlace<Side::Left, UpLo::Lower, Diag::Unit>(
+        block(lu_, k0, k0, k1 - k0, k1 - k0), block(lu_, k0, k1, k1 - k0, n - k1), blockSize);
+      // the next panel is updated first so that it can be factorized while the
+      // rest of the trailing matrix is updated
+      const Index k2 = std::min(k1 + blockSize, n);
+      updateTrailing(k0, k1, k1, k2);
+      auto nextPanel = std::async(std::launch::async, [this, k1, k2] { factorizePanel(k1, k2); });
+      updateTrailing(k0, k1, k2, n);
+      nextPanel.get();
+    }
+
+    for (Index i = 0; i < n; ++i) {
+      perm_[i] = i;
+    }
+    for (Index c = 0; c < n; ++c) {
+      std::swap(perm_[c], perm_[pivots_[c]]);
+    }
+  }
+
+  MatrixType lu_;
+  vector<Index> pivots_;
+  vector<Index> perm_;
+};
+
+/// \brief Cholesky decomposition `A = L * L^T` of a symmetric positive definite matrix.
+/// Only the lower triangle of `A` is read. Right-looking blocked algorithm with
+/// the same look-ahead scheme as `PartialPivLU`: the diagonal block and the
+/// panel below it are factorized on their own thread while the rest of the
+/// trailing matrix is updated.
+template<typename MatrixType>
+class LLT {
+public:
+  using Scalar = typename MatrixType::scalar_type;
+
+  explicit LLT(const MatrixType& A, Index blockSize = decomp::defaultBlockSize())
+    : l_(A)
+  {
+    CHECK_SQUARE(A);
+    factorize(std::max<Index>(blockSize, 1));
+  }
+
+  /// The lower triangular factor, the strict upper triangle is zero.
+  const MatrixType& matrixL() const { return l_; }
+
+  /// Solve `A * X = B`.
+  DISTMAT_MEM_TFUNC
+  OtherDerived solve(const MatrixBase<OtherDerived, Scalar>& B) const
+  {
+    CHECK_MUL_DIM(l_, B.derived());
+    OtherDerived X = B.derived();
+    triangularSolveInPlace<Side::Left, UpLo::Lower>(l_, X);
+    triangularSolveInPlace<Side::Left, UpLo::Upper>(transposed(block(l_)), X);
+    return X;
+  }
+
+private:
+  /// Factorize the diagonal block `[k0, k1)` and solve the panel below it.
+  void factorizeColumn(Index k0, Index k1, Index blockSize)
+  {
+    const Index n = l_.rows();
+    for (Index j = k0; j < k1; ++j) {
+      auto d = l_(j, j);
+      for (Index k = k0; k < j; ++k) {
+        d -= l_(j, k) * l_(j, k);
+      }
+      if (!(d > traits::scalar_traits<Scalar>::zero)) {
+        throw std::runtime_error(ERROR_WHERE() + "\n\tError: matrix is not positive definite");
+      }
+      l_(j, j) = std::sqrt(d);
+      for (Index i = j + 1; i < k1; ++i) {
+        auto x = l_(i, j);
+        for (Index k = k0; k < j; ++k) {
+          x -= l_(i, k) * l_(j, k);
+        }
+        l_(i, j) = x / l_(j, j);
+      }
+    }
+    if (k1 < n) {
+      // L21 = A21 * L11^-T
+      triangularSolveInPlace<Side::Right, UpLo::Upper>(transposed(block(l_, k0, k0, k1 - k0, k1 - k0)),
+        block(l_, k1, k0, n - k1, k1 - k0), blockSize);
+    }
+  }
+
+  /// `A[r, cBegin:min(r + 1, cEnd)] -= L[r, k0:k1] * L[cBegin:cEnd, k0:k1]^T` for rows `r >= cBegin`.
+  void updateTrailing(Index k0, Index k1, Index cBegin, Index cEnd)
+  {
+    const Index n = l_.rows();
+    const Index kw = k1 - k0;
+    parallel::parallelFor(cBegin, n, parallel::grainFor(kw * (cEnd - cBegin)), [&](Index lo, Index hi)
+    {
+      // only the lower triangle is needed, so the columns stop at the last row of the chunk
+      const Index cw = std::min(hi, cEnd) - cBegin;
+      mul::multiplyMatrixTransposedSubTo<Index>(block(l_, lo, k0, hi - lo, kw),
+        block(l_, cBegin, k0, cw, kw), block(l_, lo, cBegin, hi - lo, cw));
+    });
+  }
+
+  void factorize(Index blockSize)
+  {
+    const Index n = l_.rows();
+    if (n == 0) {
+      return;
+    }
+    factorizeColumn(0, std::min(blockSize, n), blockSize);
+    for (Index k0 = 0; k0 < n; k0 += blockSize) {
+      const Index k1 = std::min(k0 + blockSize, n);
+      if (k1 == n) {
+        break;
+      }
+      const Index k2 = std::min(k1 + blockSize, n);
+      updateTrailing(k0, k1, k1, k2);
+      auto nextColumn = std::async(std::launch::async, [this, k1, k2, blockSize] { factorizeColumn(k1, k2, blockSize); });
+      if (k2 < n) {
+        updateTrailing(k0, k1, k2, n);
+      }
+      nextColumn.get();
+    }
+
+    for (Index i = 0; i < n; ++i) {
+      for (Index j = i + 1; j < n; ++j) {
+        l_(i, j) = traits::scalar_traits<Scalar>::zero;
+      }
+    }
+  }
+
+  MatrixType l_;
+};
+
+/// Solve `A * X = B` with `PartialPivLU`.
+DISTMAT_BINARY_TFUNC
+_RDerived solve(const MatrixBase<_LDerived, _Scalar>& A, const MatrixBase<_RDerived, _Scalar>& B)
+{
+  return PartialPivLU<_LDerived>(A.derived()).solve(B);
+}
+
+} // namespace distmat
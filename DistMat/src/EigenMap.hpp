@@ -0,0 +1,56 @@
+#pragma once
+#include "Matrix.hpp"
+#include "Error.hpp"
+
+#include <Eigen/Core>
+
+namespace distmat
+{
+
+namespace detail {
+  /// Eigen matrix with the layout of `Matrix<Scalar, Rows, Cols>`: row major,
+  /// except for column vectors, which Eigen requires to be column major.
+  template<typename Scalar, int Rows, int Cols>
+    using EigenMatrix = Eigen::Matrix<Scalar, Rows, Cols, Cols == 1 && Rows != 1 ? Eigen::ColMajor : Eigen::RowMajor>;
+} // namespace detail
+
+/// \brief `Eigen::Map` on the coefficients of `mat`, nothing is copied.
+/// Dimensions known at compile time stay known. Eigen algorithms read and
+/// write the matrix through the map, which must not outlive it. A shared
+/// copy-on-write matrix is detached first.
+template<typename Scalar, int Rows, int Cols, typename Storage, typename Shape>
+Eigen::Map<detail::EigenMatrix<Scalar, Rows, Cols>> toEigen(Matrix<Scalar, Rows, Cols, Storage, Shape>& mat)
+{
+  return {mat.data(), Eigen::Index(mat.rows()), Eigen::Index(mat.cols())};
+}
+
+template<typename Scalar, int Rows, int Cols, typename Storage, typename Shape>
+Eigen::Map<const detail::EigenMatrix<Scalar, Rows, Cols>> toEigen(const Matrix<Scalar, Rows, Cols, Storage, Shape>& mat)
+{
+  return {mat.data(), Eigen::Index(mat.rows()), Eigen::Index(mat.cols())};
+}
+
+/// \brief `MatrixMap` on the coefficients of an Eigen matrix, nothing is copied.
+/// `eigen` must be row major with contiguous rows (e.g.
+/// `Eigen::Matrix<double, -1, -1, Eigen::RowMajor>` or a map of it) or a
+/// contiguous vector, otherwise this throws. The map must not outlive `eigen`.
+template<typename EigenType>
+  requires requires (EigenType& e) { { e.data() } -> same_as<typename EigenType::Scalar*>; }
+MatrixMap<typename EigenType::Scalar> fromEigen(Eigen::DenseBase<EigenType>& eigen)
+{
+  auto& e = eigen.derived();
+  const Index rows = e.rows();
+  const Index cols = e.cols();
+  const bool isVector = rows == 1 || cols == 1;
+  const bool isContiguous = e.innerStride() == 1 &&
+    (isVector || (EigenType::IsRowMajor && Index(e.outerStride()) == cols));
+  if (!isContiguous) {
+    throw std::runtime_error(ERROR_WHERE() + "\n\tError: " +
+      "the Eigen matrix of shape (" + to_string(rows) + ", " + to_string(cols) +
+      ") is not row major with contiguous rows");
+  }
+  using Scalar = typename EigenType::Scalar;
+  return MatrixMap<Scalar>(MapStorage<Scalar>(e.data(), rows * cols), rows, cols);
+}
+
+} // namespace distmat
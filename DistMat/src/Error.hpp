@@ -27,5 +27,12 @@ namespace error
     ", " + to_string(rhs.cols()) + ")");\
   }
 
+#define CHECK_SQUARE(mat) \
+  if (mat.rows() != mat.cols()) {\
+    throw std::runtime_error(ERROR_WHERE() + "\n\tError: " +\
+    "shape (" + to_string(mat.rows()) + ", " + to_string(mat.cols()) +\
+    ") is not square");\
+  }
+
 } // namespace error
 } // namespace distmat
@@ -0,0 +1,347 @@
+#pragma once
+#include "Matrix.hpp"
+#include "Parallel.hpp"
+#include "Error.hpp"
+
+#include <charconv>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <filesystem>
+#include <string_view>
+#include <atomic>
+#include <limits>
+#include <algorithm>
+
+namespace distmat
+{
+namespace io
+{
+
+struct TextFormat {
+  /// Separator written between the coefficients of a row. The reader accepts
+  /// any of ' ', '\t', ',' and ';', so it reads both CSV and whitespace separated text.
+  /// Runs of whitespace are one separator, but ',' and ';' end a field each,
+  /// so an empty field like in "1,,3" is an error.
+  char delimiter = ' ';
+  /// Format (write) or parse (read) chunks of rows on `parallel::numThreads()` threads.
+  bool parallel = true;
+};
+
+namespace detail {
+  /// Bytes formatted per thread before they are written.
+  inline constexpr Index writeBufferBytes = Index(1) << 22;
+  /// Enough for the shortest representation of any arithmetic type.
+  inline constexpr Index maxCharsPerCoeff = 32;
+
+  inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+  inline bool isDelimiter(char c) { return c == ',' || c == ';'; }
+  inline bool isSeparator(char c) { return isSpace(c) || isDelimiter(c); }
+
+  inline bool isBlank(std::string_view line)
+  {
+    return std::all_of(line.begin(), line.end(), isSpace);
+  }
+
+  /// `std::from_chars`. Floating point falls back to `strtod` where the
+  /// standard library lacks it (libstdc++ before 11), which depends on the
+  /// C locale.
+  template<typename Scalar>
+  std::from_chars_result fromChars(const char* first, const char* last, Scalar& value)
+  {
+#ifndef __cpp_lib_to_chars
+    if constexpr (std::is_floating_point_v<Scalar>) {
+      // strtod needs a terminated string
+      char token[2 * maxCharsPerCoeff];
+      const char* tokenEnd = std::find_if(first, last, isSeparator);
+      if (tokenEnd - first >= std::ptrdiff_t(sizeof(token))) {
+        return {first, std::errc::invalid_argument};
+      }
+      std::copy(first, tokenEnd, token);
+      token[tokenEnd - first] = '\0';
+      char* parsed = nullptr;
+      errno = 0;
+      if constexpr (std::is_same_v<Scalar, float>) {
+        value = std::strtof(token, &parsed);
+      } else if constexpr (std::is_same_v<Scalar, double>) {
+        value = std::strtod(token, &parsed);
+      } else {
+        value = std::strtold(token, &parsed);
+      }
+      if (parsed == token) {
+        return {first, std::errc::invalid_argument};
+      }
+      return {first + (parsed - token), errno == ERANGE ? std::errc::result_out_of_range : std::errc()};
+    } else
+#endif
+    {
+      return std::from_chars(first, last, value);
+    }
+  }
+
+  /// `std::to_chars`. Floating point falls back to `snprintf` with enough
+  /// digits to read back exactly where the standard library lacks it.
+  template<typename Scalar>
+  std::to_chars_result toChars(char* first, char* last, const Scalar& value)
+  {
+#ifndef __cpp_lib_to_chars
+    if constexpr (std::is_floating_point_v<Scalar>) {
+      constexpr int digits = std::numeric_limits<Scalar>::max_digits10;
+      const int n = std::is_same_v<Scalar, long double>
+        ? std::snprintf(first, last - first, "%.*Lg", digits, static_cast<long double>(value))
+        : std::snprintf(first, last - first, "%.*g", digits, static_cast<double>(value));
+      if (n < 0 || n >= last - first) {
+        return {last, std::errc::value_too_large};
+      }
+      return {first + n, std::errc()};
+    } else
+#endif
+    {
+      return std::to_chars(first, last, value);
+    }
+  }
+
+  /// Call `f(line)` for every non blank line of `text`.
+  template<typename F>
+  void forEachLine(std::string_view text, F&& f)
+  {
+    while (!text.empty()) {
+      const auto eol = text.find('\n');
+      const auto line = text.substr(0, eol);
+      if (!isBlank(line)) {
+        f(line);
+      }
+      text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+    }
+  }
+
+  /// Parse the coefficients of `line` into `out[0:count]`, returns the number of
+  /// coefficients in the line (which may differ from `count`), or -1 on a parse
+  /// error or an empty field.
+  template<typename Scalar>
+  std::ptrdiff_t parseLine(std::string_view line, Scalar* out, Index count)
+  {
+    const char* p = line.data();
+    const char* const end = line.data() + line.size();
+    std::ptrdiff_t n = 0;
+    // a ',' or ';' was read, so a coefficient must follow
+    bool isFieldOpen = false;
+    while (true) {
+      while (p != end && isSpace(*p)) {
+        ++p;
+      }
+      if (p == end) {
+        return isFieldOpen ? -1 : n;
+      }
+      if (isDelimiter(*p)) {
+        if (n == 0 || isFieldOpen) {
+          return -1;
+        }
+        isFieldOpen = true;
+        ++p;
+        continue;
+      }
+      isFieldOpen = false;
+      if (*p == '+') {
+        ++p;
+      }
+      Scalar value{};
+      const auto [next, ec] = fromChars(p, end, value);
+      if (ec != std::errc() || (next != end && !isSeparator(*next))) {
+        return -1;
+      }
+      if (Index(n) < count) {
+        out[n] = value;
+      }
+      ++n;
+      p = next;
+    }
+  }
+
+  /// Split `text` into `n` chunks that start at the beginning of a line.
+  inline vector<std::string_view> splitLines(std::string_view text, Index n)
+  {
+    vector<std::string_view> chunks;
+    Index begin = 0;
+    for (Index t = 1; t <= n && begin < text.size(); ++t) {
+      Index end = t == n ? text.size() : std::max(begin, text.size() * t / n);
+      if (end < text.size()) {
+        end = text.find('\n', end);
+        end = end == std::string_view::npos ? text.size() : end + 1;
+      }
+      chunks.push_back(text.substr(begin, end - begin));
+      begin = end;
+    }
+    return chunks;
+  }
+} // namespace detail
+
+/// \brief Parse a matrix from text, one row per line.
+/// The text is split into chunks of whole lines, the rows of every chunk are
+/// counted and then parsed with `std::from_chars` in parallel into the
+/// preallocated matrix. Blank lines are skipped. Throws if a coefficient is not
+/// a number or empty, or the rows don't have the same number of coefficients.
+template<typename MatrixType = Matrix<double>>
+MatrixType parseText(std::string_view text, const TextFormat& format = {})
+{
+  using Scalar = typename MatrixType::scalar_type;
+  const auto chunks = detail::splitLines(text, format.parallel ? parallel::numThreads() : 1);
+
+  Index cols = 0;
+  for (const auto& chunk : chunks) {
+    bool isFound = false;
+    detail::forEachLine(chunk, [&](std::string_view line)
+    {
+      if (!isFound) {
+        const auto n = detail::parseLine<Scalar>(line, nullptr, 0);
+        if (n < 0) {
+          throw std::runtime_error(ERROR_WHERE() + "\n\tError: invalid number in the first row");
+        }
+        cols = n;
+        isFound = true;
+      }
+    });
+    if (isFound) {
+      break;
+    }
+  }
+
+  // rows of every chunk, then the first row of every chunk
+  vector<Index> rowBegin(chunks.size() + 1, 0);
+  parallel::parallelFor(0, chunks.size(), 1, [&](Index lo, Index hi)
+  {
+    for (Index c = lo; c < hi; ++c) {
+      detail::forEachLine(chunks[c], [&](std::string_view) { ++rowBegin[c + 1]; });
+    }
+  });
+  for (Index c = 0; c < chunks.size(); ++c) {
+    rowBegin[c + 1] += rowBegin[c];
+  }
+
+  // rows are parsed directly into the row major storage
+  auto mat = distmat::detail::makeMatrix<MatrixType>(rowBegin.back(), cols);
+  std::atomic<Index> badRow{std::numeric_limits<Index>::max()};
+  parallel::parallelFor(0, chunks.size(), 1, [&](Index lo, Index hi)
+  {
+    for (Index c = lo; c < hi; ++c) {
+      Index row = rowBegin[c];
+      detail::forEachLine(chunks[c], [&](std::string_view line)
+      {
+        if (detail::parseLine<Scalar>(line, &mat(row, 0), cols) != std::ptrdiff_t(cols)) {
+          Index expected = badRow.load();
+          while (row < expected && !badRow.compare_exchange_weak(expected, row)) {}
+        }
+        ++row;
+      });
+    }
+  });
+  if (badRow.load() != std::numeric_limits<Index>::max()) {
+    throw std::runtime_error(ERROR_WHERE() + "\n\tError: row " + to_string(badRow.load()) +
+      " is not a row of " + to_string(cols) + " numbers");
+  }
+  return mat;
+}
+
+/// Read the rest of a stream, from its current position, and parse it with
+/// `parseText`.
+template<typename MatrixType = Matrix<double>>
+MatrixType readText(std::istream& in, const TextFormat& format = {})
+{
+  string text;
+  const auto begin = in.tellg();
+  std::streamoff size = -1;
+  if (begin != std::istream::pos_type(-1)) {
+    in.seekg(0, std::ios::end);
+    size = in.tellg() - begin;
+  }
+  if (size > 0) {
+    in.seekg(begin);
+    text.resize(size);
+    in.read(text.data(), size);
+    text.resize(in.gcount());
+  } else {
+    in.clear();
+    text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  return parseText<MatrixType>(text, format);
+}
+
+template<typename MatrixType = Matrix<double>>
+MatrixType readTextFile(const std::filesystem::path& path, const TextFormat& format = {})
+{
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error(ERROR_WHERE() + "\n\tError: can not open " + path.string());
+  }
+  return readText<MatrixType>(in, format);
+}
+
+/// \brief Write a matrix as text, one row per line.
+/// Coefficients are formatted with `std::to_chars` (shortest representation
+/// that reads back exactly, see `detail::toChars` for older standard
+/// libraries) into large per-thread buffers, a batch of rows at a time, and
+/// every buffer is written with a single `write`. The stream is never flushed.
+/// Throws if a coefficient can not be formatted.
+DISTMAT_TFUNC
+void writeText(std::ostream& out, const MatrixBase<_Derived, _Scalar>& matrix, const TextFormat& format = {})
+{
+  const auto& mat = matrix.derived();
+  const Index rows = mat.rows();
+  const Index cols = mat.cols();
+  const Index threads = format.parallel ? parallel::numThreads() : 1;
+  const Index rowsPerBuffer = std::max<Index>(1, detail::writeBufferBytes / std::max<Index>(1, cols * detail::maxCharsPerCoeff));
+
+  vector<string> buffers(threads);
+  std::atomic<bool> isFormatted{true};
+  for (Index batch = 0; batch < rows; batch += rowsPerBuffer * threads) {
+    const Index batchEnd = std::min(rows, batch + rowsPerBuffer * threads);
+    // every chunk of the batch is formatted into its own buffer, in parallel
+    parallel::parallelFor(0, threads, 1, [&](Index lo, Index hi)
+    {
+      for (Index t = lo; t < hi; ++t) {
+        auto& buffer = buffers[t];
+        buffer.clear();
+        const Index rowEnd = std::min(batchEnd, batch + (t + 1) * rowsPerBuffer);
+        for (Index row = batch + t * rowsPerBuffer; row < rowEnd; ++row) {
+          for (Index col = 0; col < cols; ++col) {
+            char tmp[detail::maxCharsPerCoeff];
+            const auto result = detail::toChars(tmp, tmp + sizeof(tmp), mat(row, col));
+            if (result.ec != std::errc()) {
+              isFormatted.store(false, std::memory_order_relaxed);
+              return;
+            }
+            buffer.append(tmp, result.ptr);
+            buffer.push_back(col + 1 == cols ? '\n' : format.delimiter);
+          }
+          if (cols == 0) {
+            buffer.push_back('\n');
+          }
+        }
+      }
+    });
+    if (!isFormatted.load(std::memory_order_relaxed)) {
+      throw std::runtime_error(ERROR_WHERE() + "\n\tError: a coefficient does not fit in " +
+        to_string(detail::maxCharsPerCoeff) + " characters");
+    }
+    for (const auto& buffer : buffers) {
+      out.write(buffer.data(), std::streamsize(buffer.size()));
+    }
+  }
+  if (!out) {
+    throw std::runtime_error(ERROR_WHERE() + "\n\tError: failed to write the matrix");
+  }
+}
+
+DISTMAT_TFUNC
+void writeTextFile(const std::filesystem::path& path, const MatrixBase<_Derived, _Scalar>& matrix, const TextFormat& format = {})
+{
+  std::ofstream out(path, std::ios::binary);
+  if (!out) {
+    throw std::runtime_error(ERROR_WHERE() + "\n\tError: can not open " + path.string());
+  }
+  writeText(out, matrix, format);
+}
+
+} // namespace io
+} // namespace distmat
@@ -0,0 +1,521 @@
+#pragma once
+#include "Matrix.hpp"
+#include "Parallel.hpp"
+#include "Error.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <functional>
+#include <utility>
+
+namespace distmat
+{
+
+namespace iterative {
+
+/// Stopping criteria of the iterative solvers.
+struct Options {
+  /// Stop once `||b - A * x|| <= tolerance * ||b||`.
+  double tolerance = 1e-10;
+  Index maxIterations = 1000;
+};
+
+/// Outcome of `solve`.
+struct Info {
+  Index iterations = 0;
+  /// `||b - A * x|| / ||b||` of the returned `x`, as given by the recurrences.
+  double residual = 0;
+  bool converged = false;
+};
+
+/// Work vectors of the solvers, columns of `n` coefficients.
+template<typename Scalar>
+using Vector = Matrix<Scalar>;
+
+/// A dense square matrix, or a callable `op(x, y)` that sets `y = A * x`,
+/// e.g. a matrix-free stencil.
+template<typename Op, typename Scalar>
+  concept LinearOperator = derived_from<Op, MatrixBase<Op, Scalar>>
+    || std::invocable<const Op&, const Vector<Scalar>&, Vector<Scalar>&>;
+
+/// `M.apply(r, z)` sets `z = M^-1 * r`.
+template<typename P, typename Scalar>
+  concept Preconditioner = requires (const P& M, const Vector<Scalar>& r, Vector<Scalar>& z) { M.apply(r, z); };
+
+/// No preconditioning, the solvers then skip the preconditioned vectors.
+struct IdentityPreconditioner {
+  template<typename Scalar>
+  void apply(const Vector<Scalar>& r, Vector<Scalar>& z) const { z = r; }
+};
+
+/// \brief Jacobi (diagonal) preconditioner, `M = diag(A)`.
+/// The solvers apply it inside their update passes instead of a pass of its own.
+template<typename Scalar>
+class JacobiPreconditioner {
+public:
+  /// From the diagonal of a dense matrix, which must not have zeros.
+  template<typename Derived>
+  explicit JacobiPreconditioner(const MatrixBase<Derived, Scalar>& A)
+    : inverseDiagonal_(A.derived().rows(), 1)
+  {
+    const auto& a = A.derived();
+    CHECK_SQUARE(a);
+    for (Index i = 0; i < a.rows(); ++i) {
+      if (a(i, i) == traits::scalar_traits<Scalar>::zero) {
+        throw std::runtime_error(ERROR_WHERE() + "\n\tError: zero on the diagonal at " + to_string(i));
+      }
+      inverseDiagonal_[i] = traits::scalar_traits<Scalar>::one / a(i, i);
+    }
+  }
+
+  /// From the inverse of the diagonal, e.g. of a linear operator callback.
+  static JacobiPreconditioner fromInverseDiagonal(Vector<Scalar> inverseDiagonal)
+  {
+    JacobiPreconditioner ret;
+    ret.inverseDiagonal_ = std::move(inverseDiagonal);
+    return ret;
+  }
+
+  const Vector<Scalar>& inverseDiagonal() const { return inverseDiagonal_; }
+
+  void apply(const Vector<Scalar>& r, Vector<Scalar>& z) const
+  {
+    parallel::parallelFor(0, r.size(), parallel::coeffWiseGrain(), [&](Index lo, Index hi)
+    {
+      for (Index i = lo; i < hi; ++i) {
+        z[i] = inverseDiagonal_[i] * r[i];
+      }
+    });
+  }
+
+private:
+  JacobiPreconditioner() = default;
+
+  Vector<Scalar> inverseDiagonal_;
+};
+
+namespace detail {
+  /// Dot products computed by a pass.
+  template<typename Scalar>
+  using Sums = std::array<Scalar, 3>;
+
+  template<typename P>
+    concept DiagonalPreconditioner = requires (const P& M) { M.inverseDiagonal(); };
+
+  template<typename P>
+  inline constexpr bool isIdentity = same_as<P, IdentityPreconditioner>;
+
+  /// Split `[0, n)` into at most `partial.size()` chunks of at least `grain`
+  /// indices, `f(lo, hi, sums)` adds the dot products of its chunk to `sums`.
+  /// The chunk sums are added in chunk order, so the result depends on the
+  /// number of threads but not on their scheduling.
+  template<typename Scalar, typename F>
+  Sums<Scalar> reduceChunks(Index n, Index grain, vector<Sums<Scalar>>& partial, F&& f)
+  {
+    const Index nChunks = std::clamp<Index>(n / std::max<Index>(grain, 1), 1, Index(partial.size()));
+    auto chunkBegin = [=](Index t) { return n * t / nChunks; };
+    parallel::parallelFor(0, nChunks, 1, [&](Index lo, Index hi)
+    {
+      for (Index t = lo; t < hi; ++t) {
+        partial[t] = {};
+        f(chunkBegin(t), chunkBegin(t + 1), partial[t]);
+      }
+    });
+    Sums<Scalar> sums{};
+    for (Index t = 0; t < nChunks; ++t) {
+      for (std::size_t k = 0; k < sums.size(); ++k) {
+        sums[k] += partial[t][k];
+      }
+    }
+    return sums;
+  }
+
+  /// `{x . y, 0, 0}`
+  template<typename Scalar>
+  Sums<Scalar> dot(const Vector<Scalar>& x, const Vector<Scalar>& y, vector<Sums<Scalar>>& partial)
+  {
+    return reduceChunks<Scalar>(x.size(), parallel::coeffWiseGrain(), partial, [&](Index lo, Index hi, Sums<Scalar>& sums)
+    {
+      for (Index i = lo; i < hi; ++i) {
+        sums[0] += x[i] * y[i];
+      }
+    });
+  }
+
+  /// `y = A * x` and `{w . y, y . y, 0}`. A dense `A` computes the dot products
+  /// of every chunk of rows right after the chunk of `y`, while it is in cache.
+  template<typename Scalar, typename Op>
+  Sums<Scalar> applyOperator(const Op& A, const Vector<Scalar>& x, Vector<Scalar>& y, const Vector<Scalar>& w,
+    vector<Sums<Scalar>>& partial)
+  {
+    const auto dots = [&](Index lo, Index hi, Sums<Scalar>& sums)
+    {
+      for (Index i = lo; i < hi; ++i) {
+        sums[0] += w[i] * y[i];
+        sums[1] += y[i] * y[i];
+      }
+    };
+    if constexpr (derived_from<Op, MatrixBase<Op, Scalar>>) {
+      return reduceChunks<Scalar>(A.rows(), parallel::grainFor(A.cols()), partial, [&](Index lo, Index hi, Sums<Scalar>& sums)
+      {
+        mul::multiplyVectorRows<Index>(A, x, y, traits::scalar_traits<Scalar>::one, traits::scalar_traits<Scalar>::zero, lo, hi);
+        dots(lo, hi, sums);
+      });
+    } else {
+      std::invoke(A, x, y);
+      return reduceChunks<Scalar>(y.size(), parallel::coeffWiseGrain(), partial, dots);
+    }
+  }
+
+  /// Check the shapes, including the inverse diagonal `d` of a Jacobi
+  /// preconditioner if any, and make sure the work vectors and the chunk sums
+  /// fit `n`, which only allocates when `n` or the number of threads changed.
+  template<typename Scalar, typename Op>
+  void prepare(const Op& A, const auto& b, const auto& x, std::initializer_list<Vector<Scalar>*> vectors,
+    vector<Sums<Scalar>>& partial, const Vector<Scalar>* d = nullptr)
+  {
+    const Index n = b.rows();
+    distmat::detail::checkVectors(b, x, n, n, false);
+    if constexpr (derived_from<Op, MatrixBase<Op, Scalar>>) {
+      CHECK_SQUARE(A);
+      CHECK_MUL_DIM(A, b);
+    }
+    if (d != nullptr && (d->rows() != n || d->cols() != 1)) {
+      throw std::runtime_error(ERROR_WHERE() + "\n\tError: the inverse diagonal has shape (" +
+        to_string(d->rows()) + ", " + to_string(d->cols()) + "), expected (" + to_string(n) + ", 1)");
+    }
+    for (auto* v : vectors) {
+      if (v->rows() != n || v->cols() != 1) {
+        *v = Vector<Scalar>(n, 1);
+      }
+    }
+    if (partial.size() < parallel::numThreads()) {
+      partial.resize(parallel::numThreads());
+    }
+  }
+
+  /// `x = 0`, the solution for `b = 0`.
+  void setZero(auto& x)
+  {
+    for (Index i = 0; i < x.size(); ++i) {
+      x[i] = 0;
+    }
+  }
+
+  /// `dst = src` for a vector of another type.
+  template<typename Scalar>
+  void copy(const auto& src, Vector<Scalar>& dst)
+  {
+    parallel::parallelFor(0, dst.size(), parallel::coeffWiseGrain(), [&](Index lo, Index hi)
+    {
+      for (Index i = lo; i < hi; ++i) {
+        dst[i] = src[i];
+      }
+    });
+  }
+} // namespace detail
+} // namespace iterative
+
+/// \brief Conjugate gradient for a symmetric positive definite `A`, the
+/// preconditioned variant (PCG) when `solve` is given a preconditioner.
+/// The work vectors are allocated once for a size, so the iterations do not
+/// allocate. Every iteration makes three passes over the vectors instead of
+/// the five of CG written with the operators:
+/// - `q = A * p` together with `p . q`
+/// - `x += alpha * p`, `r -= alpha * q` together with `r . r`, and with
+///   `z = M^-1 * r`, `r . z` for a `JacobiPreconditioner`
+/// - `p = z + beta * p`
+template<typename Scalar>
+class ConjugateGradient {
+public:
+  using Vector = iterative::Vector<Scalar>;
+
+  /// \param n length of the vectors, a `solve` of another length reallocates them once
+  explicit ConjugateGradient(Index n = 0, iterative::Options options = {})
+    : options_(options), r_(n, 1), p_(n, 1), q_(n, 1), z_(0, 1)
+  {}
+
+  iterative::Options& options() { return options_; }
+  const iterative::Options& options() const { return options_; }
+
+  /// Solve `A * x = b` starting from the given `x`, which holds the solution on return.
+  /// \param A dense matrix or `op(x, y)` setting `y = A * x`
+  /// \param M preconditioner, `IdentityPreconditioner` for plain CG
+  template<typename Op, typename BDerived, typename XDerived, typename Precond = iterative::IdentityPreconditioner>
+    requires iterative::LinearOperator<Op, Scalar> && iterative::Preconditioner<Precond, Scalar>
+  iterative::Info solve(const Op& A, const MatrixBase<BDerived, Scalar>& b, MatrixBase<XDerived, Scalar>& x,
+    const Precond& M = {})
+  {
+    using namespace iterative::detail;
+    constexpr bool identity = isIdentity<Precond>;
+    constexpr bool diagonal = DiagonalPreconditioner<Precond>;
+    const auto& bv = b.derived();
+    auto& xv = x.derived();
+    const Vector* d = nullptr;
+    if constexpr (diagonal) {
+      d = &M.inverseDiagonal();
+    }
+    if constexpr (identity) {
+      prepare<Scalar>(A, bv, xv, {&r_, &p_, &q_}, partial_);
+    } else {
+      prepare<Scalar>(A, bv, xv, {&r_, &p_, &q_, &z_}, partial_, d);
+    }
+    const Index n = bv.rows();
+    const Index grain = parallel::coeffWiseGrain();
+    Vector& z = identity ? r_ : z_;
+
+    // r = b - A * x, z = M^-1 * r, p = z
+    copy<Scalar>(xv, p_);
+    applyOperator<Scalar>(A, p_, q_, p_, partial_);
+    auto sums = reduceChunks<Scalar>(n, grain, partial_, [&](Index lo, Index hi, Sums<Scalar>& s)
+    {
+      for (Index i = lo; i < hi; ++i) {
+        r_[i] = bv[i] - q_[i];
+        s[0] += bv[i] * bv[i];
+        s[1] += r_[i] * r_[i];
+        if constexpr (diagonal) {
+          z_[i] = (*d)[i] * r_[i];
+          s[2] += r_[i] * z_[i];
+        }
+      }
+    });
+    const Scalar bb = sums[0];
+    Scalar rr = sums[1];
+    iterative::Info info;
+    if (bb == traits::scalar_traits<Scalar>::zero) {
+      setZero(xv);
+      info.converged = true;
+      return info;
+    }
+    Scalar rz = preconditionedDot(M, rr, sums[2]);
+    copy<Scalar>(z, p_);
+
+    const Scalar threshold = Scalar(options_.tolerance * options_.tolerance) * bb;
+    info.converged = rr <= threshold;
+    for (Index it = 1; it <= options_.maxIterations && !info.converged; ++it) {
+      const Scalar pq = applyOperator<Scalar>(A, p_, q_, p_, partial_)[0];
+      if (pq == traits::scalar_traits<Scalar>::zero) {
+        break;
+      }
+      const Scalar alpha = rz / pq;
+      sums = reduceChunks<Scalar>(n, grain, partial_, [&](Index lo, Index hi, Sums<Scalar>& s)
+      {
+        for (Index i = lo; i < hi; ++i) {
+          xv[i] += alpha * p_[i];
+          r_[i] -= alpha * q_[i];
+          s[0] += r_[i] * r_[i];
+          if constexpr (diagonal) {
+            z_[i] = (*d)[i] * r_[i];
+            s[1] += r_[i] * z_[i];
+          }
+        }
+      });
+      rr = sums[0];
+      info.iterations = it;
+      info.converged = rr <= threshold;
+      if (info.converged) {
+        break;
+      }
+      const Scalar rzNew = preconditionedDot(M, rr, sums[1]);
+      const Scalar beta = rzNew / rz;
+      rz = rzNew;
+      parallel::parallelFor(0, n, grain, [&](Index lo, Index hi)
+      {
+        for (Index i = lo; i < hi; ++i) {
+          p_[i] = z[i] + beta * p_[i];
+        }
+      });
+    }
+    info.residual = double(std::sqrt(rr / bb));
+    return info;
+  }
+
+private:
+  /// `r . z`, given `r . r` and the `r . z` of a fused diagonal preconditioner.
+  template<typename Precond>
+  Scalar preconditionedDot(const Precond& M, Scalar rr, Scalar fusedRz)
+  {
+    if constexpr (iterative::detail::isIdentity<Precond>) {
+      return rr;
+    } else if constexpr (iterative::detail::DiagonalPreconditioner<Precond>) {
+      return fusedRz;
+    } else {
+      M.apply(r_, z_);
+      return iterative::detail::dot<Scalar>(r_, z_, partial_)[0];
+    }
+  }
+
+  iterative::Options options_;
+  Vector r_;
+  Vector p_;
+  Vector q_;
+  Vector z_;
+  vector<iterative::detail::Sums<Scalar>> partial_;
+};
+
+/// \brief Biconjugate gradient stabilized (BiCGSTAB) for a general square `A`,
+/// right preconditioned when `solve` is given a preconditioner.
+/// Like `ConjugateGradient` the work vectors are allocated once for a size.
+/// Every iteration makes five passes: `p = r + beta * (p - omega * v)`,
+/// `v = A * p` with `rh . v`, `s = r - alpha * v` with `s . s`, `t = A * s`
+/// with `t . s` and `t . t`, and the update of `x` and `r` with `r . r` and
+/// `rh . r`. A `JacobiPreconditioner` is applied inside the first and third.
+template<typename Scalar>
+class BiCGSTAB {
+public:
+  using Vector = iterative::Vector<Scalar>;
+
+  /// \param n length of the vectors, a `solve` of another length reallocates them once
+  explicit BiCGSTAB(Index n = 0, iterative::Options options = {})
+    : options_(options), r_(n, 1), rh_(n, 1), p_(n, 1), v_(n, 1), t_(n, 1), ph_(0, 1), sh_(0, 1)
+  {}
+
+  iterative::Options& options() { return options_; }
+  const iterative::Options& options() const { return options_; }
+
+  /// Solve `A * x = b` starting from the given `x`, which holds the solution on return.
+  /// \param A dense matrix or `op(x, y)` setting `y = A * x`
+  /// \param M preconditioner, `IdentityPreconditioner` for none
+  template<typename Op, typename BDerived, typename XDerived, typename Precond = iterative::IdentityPreconditioner>
+    requires iterative::LinearOperator<Op, Scalar> && iterative::Preconditioner<Precond, Scalar>
+  iterative::Info solve(const Op& A, const MatrixBase<BDerived, Scalar>& b, MatrixBase<XDerived, Scalar>& x,
+    const Precond& M = {})
+  {
+    using namespace iterative::detail;
+    constexpr bool identity = isIdentity<Precond>;
+    constexpr bool diagonal = DiagonalPreconditioner<Precond>;
+    constexpr Scalar zero = traits::scalar_traits<Scalar>::zero;
+    const auto& bv = b.derived();
+    auto& xv = x.derived();
+    const Vector* d = nullptr;
+    if constexpr (diagonal) {
+      d = &M.inverseDiagonal();
+    }
+    if constexpr (identity) {
+      prepare<Scalar>(A, bv, xv, {&r_, &rh_, &p_, &v_, &t_}, partial_);
+    } else {
+      prepare<Scalar>(A, bv, xv, {&r_, &rh_, &p_, &v_, &t_, &ph_, &sh_}, partial_, d);
+    }
+    const Index n = bv.rows();
+    const Index grain = parallel::coeffWiseGrain();
+    // the preconditioned p and s, s is kept in r
+    Vector& ph = identity ? p_ : ph_;
+    Vector& sh = identity ? r_ : sh_;
+
+    // r = rh = b - A * x
+    copy<Scalar>(xv, p_);
+    applyOperator<Scalar>(A, p_, v_, p_, partial_);
+    auto sums = reduceChunks<Scalar>(n, grain, partial_, [&](Index lo, Index hi, Sums<Scalar>& s)
+    {
+      for (Index i = lo; i < hi; ++i) {
+        r_[i] = bv[i] - v_[i];
+        rh_[i] = r_[i];
+        s[0] += bv[i] * bv[i];
+        s[1] += r_[i] * r_[i];
+      }
+    });
+    const Scalar bb = sums[0];
+    Scalar rr = sums[1];
+    Scalar rho = rr;
+    Scalar rhoOld = traits::scalar_traits<Scalar>::one;
+    Scalar alpha = traits::scalar_traits<Scalar>::one;
+    Scalar omega = traits::scalar_traits<Scalar>::one;
+
+    iterative::Info info;
+    if (bb == zero) {
+      setZero(xv);
+      info.converged = true;
+      return info;
+    }
+    const Scalar threshold = Scalar(options_.tolerance * options_.tolerance) * bb;
+    info.converged = rr <= threshold;
+    for (Index it = 1; it <= options_.maxIterations && !info.converged; ++it) {
+      if (rho == zero || omega == zero) {
+        break;
+      }
+      // the first direction is r itself
+      const Scalar beta = it == 1 ? zero : (rho / rhoOld) * (alpha / omega);
+      const Scalar betaOmega = beta * omega;
+      parallel::parallelFor(0, n, grain, [&](Index lo, Index hi)
+      {
+        for (Index i = lo; i < hi; ++i) {
+          p_[i] = it == 1 ? r_[i] : r_[i] + beta * p_[i] - betaOmega * v_[i];
+          if constexpr (diagonal) {
+            ph_[i] = (*d)[i] * p_[i];
+          }
+        }
+      });
+      if constexpr (!identity && !diagonal) {
+        M.apply(p_, ph_);
+      }
+
+      const Scalar rhv = applyOperator<Scalar>(A, ph, v_, rh_, partial_)[0];
+      if (rhv == zero) {
+        break;
+      }
+      alpha = rho / rhv;
+      sums = reduceChunks<Scalar>(n, grain, partial_, [&](Index lo, Index hi, Sums<Scalar>& s)
+      {
+        for (Index i = lo; i < hi; ++i) {
+          r_[i] -= alpha * v_[i];
+          s[0] += r_[i] * r_[i];
+          if constexpr (diagonal) {
+            sh_[i] = (*d)[i] * r_[i];
+          }
+        }
+      });
+      info.iterations = it;
+      if (sums[0] <= threshold) {
+        // x += alpha * ph is enough
+        parallel::parallelFor(0, n, grain, [&](Index lo, Index hi)
+        {
+          for (Index i = lo; i < hi; ++i) {
+            xv[i] += alpha * ph[i];
+          }
+        });
+        rr = sums[0];
+        info.converged = true;
+        break;
+      }
+      if constexpr (!identity && !diagonal) {
+        M.apply(r_, sh_);
+      }
+
+      sums = applyOperator<Scalar>(A, sh, t_, r_, partial_);
+      if (sums[1] == zero) {
+        break;
+      }
+      omega = sums[0] / sums[1];
+      sums = reduceChunks<Scalar>(n, grain, partial_, [&](Index lo, Index hi, Sums<Scalar>& s)
+      {
+        for (Index i = lo; i < hi; ++i) {
+          xv[i] += alpha * ph[i] + omega * sh[i];
+          r_[i] -= omega * t_[i];
+          s[0] += r_[i] * r_[i];
+          s[1] += rh_[i] * r_[i];
+        }
+      });
+      rr = sums[0];
+      rhoOld = rho;
+      rho = sums[1];
+      info.converged = rr <= threshold;
+    }
+    info.residual = double(std::sqrt(rr / bb));
+    return info;
+  }
+
+private:
+  iterative::Options options_;
+  Vector r_;
+  Vector rh_;
+  Vector p_;
+  Vector v_;
+  Vector t_;
+  Vector ph_;
+  Vector sh_;
+  vector<iterative::detail::Sums<Scalar>> partial_;
+};
+
+} // namespace distmat
@@ -0,0 +1,40 @@
+#pragma once
+#include "Type.hpp"
+
+namespace distmat
+{
+
+/// \brief Non-owning storage of coefficients owned elsewhere, e.g. by an Eigen
+/// matrix, see `MatrixMap` and `fromEigen` in EigenMap.hpp.
+/// Copies of the storage refer to the same coefficients, so assigning to a
+/// `MatrixMap` writes into the mapped memory. Results of the operators are
+/// ordinary matrices, see `traits::plain_storage`.
+template<typename Scalar>
+class MapStorage {
+public:
+  using value_type = Scalar;
+  using size_type = Index;
+  using iterator = Scalar*;
+  using const_iterator = const Scalar*;
+
+  MapStorage() = default;
+  MapStorage(Scalar* data, Index size) : data_(data), size_(size) {}
+
+  Scalar&       operator[](Index i)       { return data_[i]; }
+  const Scalar& operator[](Index i) const { return data_[i]; }
+
+  Scalar*       data()       { return data_; }
+  const Scalar* data() const { return data_; }
+  Index size() const { return size_; }
+
+  iterator       begin()       { return data_; }
+  iterator       end()         { return data_ + size_; }
+  const_iterator begin() const { return data_; }
+  const_iterator end()   const { return data_ + size_; }
+
+private:
+  Scalar* data_ = nullptr;
+  Index size_ = 0;
+};
+
+} // namespace distmat
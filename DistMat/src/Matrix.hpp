@@ -1,6 +1,11 @@
 #pragma once
 #include "MatrixBase.hpp"
+#include "Transpose.hpp"
 #include "Util.hpp"
+#include "Numa.hpp"
+#include "SmallStorage.hpp"
+#include "SharedStorage.hpp"
+#include "MapStorage.hpp"
 
 #include <vector>
 #include <memory>
@@ -17,6 +22,11 @@ template<int X>
 template<int X>
   concept Fixed = (X > 0);
 
+/// Both dimensions are valid and at least one is only known at run time.
+template<int Rows, int Cols>
+  concept HasDynamicDim = (Dynamic<Rows> || Dynamic<Cols>)
+    && (Dynamic<Rows> || Fixed<Rows>) && (Dynamic<Cols> || Fixed<Cols>);
+
 template<typename T>
 struct error_no_internal_storage { static_assert(util::always_false_v<T>, "No internal storage is matched!"); };
 
@@ -28,8 +38,8 @@ template<int Rows, int Cols>
   struct DefaultShape<Rows, Cols> {
     Index rows() const { return rows_; }
     Index cols() const { return cols_; }
-    Index rows_;
-    Index cols_;
+    Index rows_ = 0;
+    Index cols_ = 0;
   };
 
 template<int Rows, int Cols>
@@ -39,11 +49,29 @@ template<int Rows, int Cols>
     constexpr Index cols() const { return Cols; }
   };
 
+/// Only the dynamic dimension is stored, the fixed one is a compile time
+/// constant, so loops over it have a known trip count and can be unrolled.
+template<int Rows, int Cols>
+  requires Fixed<Rows> && Dynamic<Cols>
+  struct DefaultShape<Rows, Cols> {
+    constexpr Index rows() const { return Rows; }
+    Index cols() const { return cols_; }
+    Index cols_ = 0;
+  };
+
+template<int Rows, int Cols>
+  requires Dynamic<Rows> && Fixed<Cols>
+  struct DefaultShape<Rows, Cols> {
+    Index rows() const { return rows_; }
+    constexpr Index cols() const { return Cols; }
+    Index rows_ = 0;
+  };
+
 template<
   IsScalar Scalar,
   int Rows = -1,
   int Cols = -1,
-  typename InternalStorage = conditional_t<Rows == -1 && Cols == -1,
+  typename InternalStorage = conditional_t<HasDynamicDim<Rows, Cols>,
     vector<Scalar, util::default_init_allocator<Scalar>>,
     conditional_t<(Rows > 0 && Cols > 0),
       std::array<Scalar, Rows * Cols>,
@@ -58,6 +86,9 @@ template<IsScalar Scalar, int Rows, int Cols, typename InternalStorage, typename
 class Matrix : public MatrixBase<Matrix<Scalar, Rows, Cols, InternalStorage, Shape>, Scalar> {
 public:
   using scalar_type = Scalar;
+  static constexpr int rowsAtCompileTime = Rows;
+  static constexpr int colsAtCompileTime = Cols;
+  using storage_type = InternalStorage;
   using Base = MatrixBase<Matrix, Scalar>;
   using Base::const_derived;
 
@@ -67,9 +98,46 @@ public:
 
   // `vector(size_t n)` will default-insert the elements, thus value-initialize the elements.
   // So we replace the default allocator with the Utils::default_init_allocator
+  // Large matrices are placed on the NUMA nodes by `numa::policy()` before
+  // anything writes to them.
+  // The fixed dimension of a partially fixed shape must match its template argument.
   template<typename T = Scalar>
-    requires is_same_v<T, Scalar> && Dynamic<Rows> && Dynamic<Cols>
-  Matrix(Index rows, Index cols) : storage_(rows * cols), shape_{rows, cols} {}
+    requires is_same_v<T, Scalar> && HasDynamicDim<Rows, Cols>
+  Matrix(Index rows, Index cols) : storage_(checkShape(rows, cols) * cols), shape_{makeShape(rows, cols)}
+  {
+    numa::place(storage_.data(), storage_.size(), cols);
+  }
+
+  /// Construct with an explicit NUMA placement policy, regardless of the size.
+  template<typename T = Scalar>
+    requires is_same_v<T, Scalar> && HasDynamicDim<Rows, Cols>
+  Matrix(Index rows, Index cols, numa::Policy policy) : storage_(checkShape(rows, cols) * cols), shape_{makeShape(rows, cols)}
+  {
+    numa::place(storage_.data(), storage_.size(), cols, policy);
+  }
+
+  /// Copy the coefficients of another kind of matrix or expression, e.g. of a
+  /// `MatrixMap` or of a `Matrix<Scalar, -1, 3>`.
+  template<typename OtherDerived>
+    requires HasDynamicDim<Rows, Cols> && (!same_as<OtherDerived, Matrix>)
+      && derived_from<OtherDerived, MatrixBase<OtherDerived, Scalar>>
+  explicit Matrix(const MatrixBase<OtherDerived, Scalar>& other) : Matrix(other.derived().rows(), other.derived().cols())
+  {
+    other.derived().evalTo(*this);
+  }
+
+  /// Construct on a given storage of `rows * cols` coefficients, e.g. a
+  /// `MapStorage` of coefficients owned elsewhere.
+  template<typename T = Scalar>
+    requires is_same_v<T, Scalar> && HasDynamicDim<Rows, Cols>
+  Matrix(InternalStorage storage, Index rows, Index cols) : storage_(std::move(storage)), shape_{makeShape(checkShape(rows, cols), cols)}
+  {
+    if (storage_.size() != rows * cols) {
+      throw std::runtime_error(ERROR_WHERE() + "\n\tError: " +
+        "storage of " + to_string(storage_.size()) + " coefficients doesn't match with shape (" +
+        to_string(rows) + ", " + to_string(cols) + ")");
+    }
+  }
 
   template<typename T = Scalar>
     requires is_same_v<T, Scalar> && Fixed<Rows> && Fixed<Cols>
@@ -82,11 +150,28 @@ public:
   Matrix& operator=(const Matrix& other)
   {
     if (this != &other) {
-      other.evalTo(*this);
+      if constexpr (requires { InternalStorage::isCopyOnWrite; }) {
+        // share the coefficients, the shape is taken over too
+        storage_ = other.storage_;
+        shape_ = other.shape_;
+      } else {
+        assign(other);
+      }
     }
     return *this;
   }
 
+  /// Assign another kind of matrix or expression, e.g. `T = A.transpose()`.
+  /// A matrix with dynamic dimensions that owns its storage takes the shape of
+  /// `other`, a `MatrixMap` writes through and must have the same shape.
+  template<typename OtherDerived>
+    requires (!same_as<OtherDerived, Matrix>) && derived_from<OtherDerived, MatrixBase<OtherDerived, Scalar>>
+  Matrix& operator=(const OtherDerived& other)
+  {
+    assign(other);
+    return *this;
+  }
+
   /// Assign matrix with initializer list, the matrix coeff is assigned row by row.
   /// e.g. `A = {1, 2, 3, 4, 5 6, 7, 8, 9};` will fill A with:
   /// 1 2 3
@@ -124,15 +209,74 @@ public:
     return storage_[i];
   }
 
+  // Mutable accesses go through the mutable accessors of the storage, which
+  // detach a copy-on-write storage before the write.
+  constexpr Scalar& operator()(Index row, Index col)
+  {
+    return storage_[row * this->cols() + col];
+  }
+  constexpr Scalar& at(Index row, Index col)
+  {
+    static_cast<const Matrix&>(*this).at(row, col);
+    return storage_[row * this->cols() + col];
+  }
+  constexpr Scalar& operator[](Index i)
+  {
+    return storage_[i];
+  }
+
   constexpr Index rows() const { return shape_.rows(); }
   constexpr Index cols() const { return shape_.cols(); }
   constexpr Index size() const { return storage_.size(); }
 
+  /// Contiguous row major coefficients, for CBLAS and `toEigen`.
+  constexpr const Scalar* data() const { return storage_.data(); }
+  constexpr Scalar*       data()       { return storage_.data(); }
+
   void foo(Scalar other)
   {
     other.call_some_func_that_dont_exist(); // OK, this is not instantiated if not called, thus don't check
   }
 private:
+  /// `*this = other`, resized to the shape of `other` if the dimensions are
+  /// dynamic. A new shape is evaluated into a new matrix, since `other` may
+  /// refer to this one, e.g. `A = A.transpose()`.
+  template<typename OtherDerived>
+  void assign(const OtherDerived& other)
+  {
+    if constexpr (HasDynamicDim<Rows, Cols> && std::is_constructible_v<InternalStorage, Index>) {
+      if (this->rows() != other.rows() || this->cols() != other.cols()) {
+        Matrix tmp(other.rows(), other.cols());
+        other.evalTo(tmp);
+        *this = std::move(tmp);
+        return;
+      }
+    }
+    other.evalTo(*this);
+  }
+
+  /// Throw if a fixed dimension is given another value, returns `rows`.
+  static Index checkShape(Index rows, Index cols)
+  {
+    if ((Fixed<Rows> && rows != Index(Rows)) || (Fixed<Cols> && cols != Index(Cols))) {
+      throw std::runtime_error(ERROR_WHERE() + "\n\tError: " +
+        "shape (" + to_string(rows) + ", " + to_string(cols) +
+        ") doesn't match with shape (" + to_string(Rows) + ", " + to_string(Cols) + ")");
+    }
+    return rows;
+  }
+
+  static Shape makeShape(Index rows, Index cols)
+  {
+    if constexpr (Dynamic<Rows> && Dynamic<Cols>) {
+      return Shape{rows, cols};
+    } else if constexpr (Dynamic<Rows>) {
+      return Shape{rows};
+    } else {
+      return Shape{cols};
+    }
+  }
+
   InternalStorage storage_;
   Shape shape_;
 
@@ -146,7 +290,7 @@ public:  // Some constexpr version of functions
     requires (Rows > 0) && (Cols > 0)
   {
     auto ret = zeros();
-    for (Index i = 0; i < std::min(Rows, Cols); ++i) {
+    for (Index i = 0; i < Index(std::min(Rows, Cols)); ++i) {
       ret(i, i) = traits::scalar_traits<Scalar>::one;
     }
     return ret;
@@ -176,6 +320,50 @@ constexpr Matrix<_Scalar, _Rows, _Cols> operator*(const Matrix<_Scalar, _Rows, _
   return tmp;
 }
 
+/// Dynamic matrix keeping up to `InlineSize` coefficients inline instead of on the heap.
+template<IsScalar Scalar, Index InlineSize = 64>
+  using SmallMatrix = Matrix<Scalar, -1, -1, SmallStorage<Scalar, InlineSize>>;
+
+/// Dynamic matrix whose copies share the coefficients until one of them is written.
+template<IsScalar Scalar>
+  using SharedMatrix = Matrix<Scalar, -1, -1, SharedStorage<Scalar>>;
+
+/// Dynamic matrix on row major coefficients owned elsewhere, see `fromEigen`.
+template<IsScalar Scalar>
+  using MatrixMap = Matrix<Scalar, -1, -1, MapStorage<Scalar>>;
+
+namespace traits {
+
+  // The product and the transpose keep every dimension that is known at compile
+  // time. They keep the storage of the operand too if they have its template
+  // shape, unless it doesn't own its coefficients.
+  template<typename Scalar, int LRows, int LCols, typename LStorage, typename LShape,
+    int RRows, int RCols, typename RStorage, typename RShape>
+    struct mul_result<Matrix<Scalar, LRows, LCols, LStorage, LShape>, Matrix<Scalar, RRows, RCols, RStorage, RShape>> {
+      using type = conditional_t<RCols == LCols,
+        Matrix<Scalar, LRows, LCols, typename plain_storage<LStorage>::type, LShape>,
+        Matrix<Scalar, LRows, RCols>>;
+    };
+
+  template<typename Scalar, int Rows, int Cols, typename Storage, typename Shape>
+    struct transpose_result<Matrix<Scalar, Rows, Cols, Storage, Shape>> {
+      using type = conditional_t<Rows == Cols,
+        Matrix<Scalar, Rows, Cols, typename plain_storage<Storage>::type, Shape>,
+        Matrix<Scalar, Cols, Rows>>;
+    };
+
+  template<typename Scalar, int Rows, int Cols, typename Storage, typename Shape>
+    struct eval_result<Matrix<Scalar, Rows, Cols, Storage, Shape>> {
+      using type = Matrix<Scalar, Rows, Cols, typename plain_storage<Storage>::type, Shape>;
+    };
+
+  template<typename Scalar>
+    struct plain_storage<MapStorage<Scalar>> {
+      using type = vector<Scalar, util::default_init_allocator<Scalar>>;
+    };
+
+}  // namespace traits
+
 namespace detail {
 
   // postpone the concept here, because during the construction of the
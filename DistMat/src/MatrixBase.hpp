@@ -1,5 +1,10 @@
 #pragma once
 #include "Multiplication.hpp"
+#include "Parallel.hpp"
+#include "Block.hpp"
+#include "Tuning.hpp"
+#include "Backend.hpp"
+#include "Random.hpp"
 
 #include "Error.hpp"
 #include "Type.hpp"
@@ -29,6 +34,29 @@ template<typename _LDerived, typename _RDerived, typename _Scalar>\
 template<typename OtherDerived>\
   requires derived_from<OtherDerived, MatrixBase<OtherDerived, Scalar>>
 
+namespace detail {
+  /// Construct a matrix of the given shape. Matrices whose shape is fully known
+  /// at compile time are value initialized and only checked.
+  template<typename Derived>
+  Derived makeMatrix(Index rows, Index cols)
+  {
+    if constexpr (std::is_constructible_v<Derived, Index, Index>) {
+      return Derived(rows, cols);
+    } else {
+      Derived ret{};
+      if (ret.rows() != rows || ret.cols() != cols) {
+        throw std::runtime_error(ERROR_WHERE() + "\n\tError: " +
+          "shape (" + to_string(rows) + ", " + to_string(cols) +
+          ") doesn't match with shape (" + to_string(ret.rows()) + ", " + to_string(ret.cols()) + ")");
+      }
+      return ret;
+    }
+  }
+} // namespace detail
+
+template<typename MatrixType>
+class TransposeView;
+
 template<typename Derived, typename Scalar>
 class MatrixBase {
 public:
@@ -39,10 +67,12 @@ public:
   constexpr const Derived& const_derived() const { return derived(); }
 
   constexpr Scalar& operator()(Index row, Index col)
+    requires (!traits::is_read_only<Derived>::value)
   {
     return const_cast<Scalar&>(const_derived()(row, col));
   }
   constexpr Scalar& at(Index row, Index col)
+    requires (!traits::is_read_only<Derived>::value)
   {
     return const_cast<Scalar&>(const_derived().at(row, col));
   }
@@ -50,6 +80,7 @@ public:
   //> Access coefficients with just one index just like the matrix is spanned
   // into a vector with row major.
   constexpr Scalar& operator[](Index i)
+    requires (!traits::is_read_only<Derived>::value)
   {
     return const_cast<Scalar&>(const_derived()[i]);
   }
@@ -61,51 +92,92 @@ public:
 
   constexpr bool isSquare() const { return derived().rows() == derived().cols(); }
 
-  Derived transpose() const;
+  /// Lazy transpose, see `TransposeView`. Nothing is copied until it is
+  /// assigned to a matrix, products such as `A * A.transpose()` are evaluated
+  /// without materializing it. The view refers to this matrix and must not
+  /// outlive it.
+  TransposeView<Derived> transpose() const& { return TransposeView<Derived>(derived()); }
+  /// A temporary would not outlive a view of it, so it is transposed eagerly,
+  /// e.g. `(A * B).transpose()` is a matrix.
+  auto transpose() && { return TransposeView<Derived>(derived()).eval(); }
 
   static Derived eye(Index row, Index col);
   static Derived zeros(Index row, Index col) { return fill(row, col, traits::scalar_traits<Scalar>::zero); }
   static Derived ones(Index row, Index col) { return fill(row, col, traits::scalar_traits<Scalar>::one); }
   static Derived fill(Index row, Index col, Scalar fillValue);
+  /// Coefficients drawn from `distribution`, e.g. `rng::Normal<Scalar>{0, 1}`,
+  /// by a Philox generator keyed by `seed`. The same seed and shape give the
+  /// same matrix whatever the number of threads, see `rng::generate`.
+  template<typename D = rng::Uniform<Scalar>>
+    requires rng::Distribution<D, Scalar>
+  static Derived random(Index row, Index col, const D& distribution = {}, std::uint64_t seed = 0)
+  {
+    auto ret = detail::makeMatrix<Derived>(row, col);
+    rng::generate<Scalar>(ret, distribution, seed);
+    return ret;
+  }
 
 // ********************** implimentations of arithematics **************************
   void mulByScalar(const Scalar& scalar);
 
-  /// Multiply two square matrices and assign to the `dst`.
+  /// Multiply a square matrix with `dst` and assign to the `dst`.
   /// `dst = (*this) * dst`
   DISTMAT_MEM_TFUNC
   void MulLeftTo(OtherDerived& dst) const
   {
-    CHECK_DIM(dst, derived());
-    assert(isSquare());
-    Derived tmp(dst.rows(), 1);
+    vector<Scalar> tmp(dst.rows());
+    MulLeftTo(dst, tmp);
+  }
+
+  /// \see MulLeftTo
+  /// \param tmp      storage of at least `dst.rows()` coefficients, reused between calls
+  DISTMAT_MEM_TFUNC
+  void MulLeftTo(OtherDerived& dst, auto& tmp) const
+  {
+    CHECK_MUL_DIM(derived(), dst);
+    assert(isSquare() && tmp.size() >= dst.rows());
     mul::multiplyMatrixLeftToInplace<Index>(dst, derived(), tmp);
   }
 
-  /// Multiply two square matrices and assign to the `dst`.
+  /// Multiply `dst` with a square matrix and assign to the `dst`.
   /// `dst = dst * (*this)`
   DISTMAT_MEM_TFUNC
   void MulRightTo(OtherDerived& dst) const
   {
-    CHECK_DIM(dst, derived());
-    assert(isSquare());
-    Derived tmp(dst.rows(), 1);
+    vector<Scalar> tmp(dst.cols());
+    MulRightTo(dst, tmp);
+  }
+
+  /// \see MulRightTo
+  /// \param tmp      storage of at least `dst.cols()` coefficients, reused between calls
+  DISTMAT_MEM_TFUNC
+  void MulRightTo(OtherDerived& dst, auto& tmp) const
+  {
+    CHECK_MUL_DIM(dst, derived());
+    assert(isSquare() && tmp.size() >= dst.cols());
     mul::multiplyMatrixRightToInplace<Index>(dst, derived(), tmp);
   }
 
-#define DEFINE_FUNC_EVAL_ADD_SUB_TO(func, op) \
+#define DEFINE_FUNC_EVAL_ADD_SUB_TO(func, op, blasCall) \
   DISTMAT_MEM_TFUNC\
   void func(OtherDerived& other) const\
   {\
     CHECK_DIM(other, derived());\
-    ranges::for_each(views::iota(Index(0), other.size()), [this, &other](Index i)\
+    if constexpr (backend::CanUseCblas<Derived, OtherDerived>) {\
+      if (backend::useCblas() && blasCall) {\
+        return;\
+      }\
+    }\
+    parallel::parallelFor(0, other.size(), parallel::coeffWiseGrain(), [this, &other](Index lo, Index hi)\
     {\
-      other[i] op derived()[i];\
+      for (Index i = lo; i < hi; ++i) {\
+        other[i] op derived()[i];\
+      }\
     });\
   }
-  DEFINE_FUNC_EVAL_ADD_SUB_TO(evalTo, =)
-  DEFINE_FUNC_EVAL_ADD_SUB_TO(addTo, +=)
-  DEFINE_FUNC_EVAL_ADD_SUB_TO(subTo, -=)
+  DEFINE_FUNC_EVAL_ADD_SUB_TO(evalTo, =, backend::copy(derived(), other))
+  DEFINE_FUNC_EVAL_ADD_SUB_TO(addTo, +=, backend::axpy(traits::scalar_traits<Scalar>::one, derived(), other))
+  DEFINE_FUNC_EVAL_ADD_SUB_TO(subTo, -=, backend::axpy(-traits::scalar_traits<Scalar>::one, derived(), other))
 #undef DEFINE_FUNC_EVAL_ADD_SUB_TO
 
 // *********************** Operators ***********************
@@ -129,7 +201,8 @@ public:
     return derived();
   }
 
-  bool operator==(const MatrixBase<Derived, Scalar>& other) const
+  template<typename OtherDerived>
+  bool operator==(const MatrixBase<OtherDerived, Scalar>& other) const
   {
     CHECK_DIM(derived(), other.derived());
     bool isEqual = true;
@@ -145,22 +218,19 @@ public:
 }; // class MatrixBase
 
 template<typename Derived, typename Scalar>
-  Derived MatrixBase<Derived, Scalar>::transpose() const
+  void MatrixBase<Derived, Scalar>::mulByScalar(const Scalar& scalar)
   {
-    Derived tmp(derived().cols(), derived().rows());
-    for (Index col = 0; col < derived().cols(); ++col) {
-      for (Index row = 0; row < derived().rows(); ++row) {
-        tmp(col, row) = derived()(row, col);
+    if constexpr (backend::CanUseCblas<Derived>) {
+      if (backend::useCblas() && backend::scal(scalar, derived())) {
+        return;
       }
     }
-    return tmp;
-  }
-
-template<typename Derived, typename Scalar>
-  void MatrixBase<Derived, Scalar>::mulByScalar(const Scalar& scalar)
-  {
-    ranges::for_each(views::iota(Index(0), derived().size()),
-      [this, scalar](Index i) { derived()[i] *= scalar; });
+    parallel::parallelFor(0, derived().size(), parallel::coeffWiseGrain(), [this, &scalar](Index lo, Index hi)
+    {
+      for (Index i = lo; i < hi; ++i) {
+        derived()[i] *= scalar;
+      }
+    });
   }
 
 template<typename Derived, typename Scalar>
@@ -176,7 +246,7 @@ template<typename Derived, typename Scalar>
 template<typename Derived, typename Scalar>
   Derived MatrixBase<Derived, Scalar>::fill(Index row, Index col, Scalar fillValue)
   {
-    Derived ret(row, col);
+    auto ret = detail::makeMatrix<Derived>(row, col);
     for (Index i = 0; i < ret.size(); ++i) {
       ret[i] = fillValue;
     }
@@ -187,56 +257,190 @@ template<typename Derived, typename Scalar>
 
 /// default binary operators
 DISTMAT_BINARY_TFUNC
-_LDerived operator+(const _LDerived& lhs, const MatrixBase<_RDerived, _Scalar>& rhs)\
+typename traits::eval_result<_LDerived>::type operator+(const _LDerived& lhs, const MatrixBase<_RDerived, _Scalar>& rhs)\
 {
-  _LDerived tmp = lhs;
+  typename traits::eval_result<_LDerived>::type tmp = lhs;
   rhs.derived().addTo(tmp);
   return tmp;
 }
 
 DISTMAT_BINARY_TFUNC
-_LDerived operator-(const _LDerived& lhs, const MatrixBase<_RDerived, _Scalar>& rhs)\
+typename traits::eval_result<_LDerived>::type operator-(const _LDerived& lhs, const MatrixBase<_RDerived, _Scalar>& rhs)\
 {
-  _LDerived tmp = lhs;
+  typename traits::eval_result<_LDerived>::type tmp = lhs;
   rhs.derived().subTo(tmp);
   return tmp;
 }
 
+namespace detail {
+  /// Throw unless `x` and `y` are column vectors (or row vectors with `isRow`)
+  /// of the lengths `xSize` and `ySize`.
+  void checkVectors(const auto& x, const auto& y, Index xSize, Index ySize, bool isRow)
+  {
+    const auto isVector = [isRow](const auto& v, Index size)
+    {
+      return (isRow ? v.rows() : v.cols()) == 1 && v.size() == size;
+    };
+    if (!isVector(x, xSize) || !isVector(y, ySize)) {
+      throw std::runtime_error(ERROR_WHERE() + "\n\tError: " +
+        "shapes (" + to_string(x.rows()) + ", " + to_string(x.cols()) + ") and (" +
+        to_string(y.rows()) + ", " + to_string(y.cols()) + ") are not " + (isRow ? "row" : "column") +
+        " vectors of " + to_string(xSize) + " and " + to_string(ySize) + " coefficients");
+    }
+  }
+} // namespace detail
+
+/// \brief `y = alpha * A * x + beta * y` for column vectors `x` and `y` (GEMV).
+/// Rows of `A` are split among the threads and every row is streamed once,
+/// `y` is written in place. With `beta == 0` the previous content of `y` is
+/// not read. `y` must not alias `x`.
+template<typename _MDerived, typename _XDerived, typename _YDerived, typename _Scalar>
+  requires derived_from<_MDerived, MatrixBase<_MDerived, _Scalar>> &&
+    derived_from<_XDerived, MatrixBase<_XDerived, _Scalar>> &&
+    derived_from<_YDerived, MatrixBase<_YDerived, _Scalar>>
+void multiplyVector(const MatrixBase<_MDerived, _Scalar>& A, const MatrixBase<_XDerived, _Scalar>& x,
+  MatrixBase<_YDerived, _Scalar>& y, const _Scalar& alpha = traits::scalar_traits<_Scalar>::one,
+  const _Scalar& beta = traits::scalar_traits<_Scalar>::zero)
+{
+  const auto& a = A.derived();
+  const auto& xv = x.derived();
+  auto& yv = y.derived();
+  detail::checkVectors(xv, yv, a.cols(), a.rows(), false);
+  if constexpr (backend::CanUseCblas<_MDerived, _XDerived, _YDerived>) {
+    if (backend::useCblas() && backend::gemv(a, xv, yv, alpha, beta, false)) {
+      return;
+    }
+  }
+  parallel::parallelFor(0, a.rows(), parallel::grainFor(a.cols()), [&](Index lo, Index hi)
+  {
+    mul::multiplyVectorRows<Index>(a, xv, yv, alpha, beta, lo, hi);
+  });
+}
+
+/// \brief `y = alpha * x * A + beta * y` for row vectors `x` and `y` (GEVM).
+/// Wide matrices are split among the threads by bands of columns, narrow ones
+/// by bands of rows whose partial results are summed afterwards. Either way
+/// `A` is streamed once. \see multiplyVector
+template<typename _XDerived, typename _MDerived, typename _YDerived, typename _Scalar>
+  requires derived_from<_XDerived, MatrixBase<_XDerived, _Scalar>> &&
+    derived_from<_MDerived, MatrixBase<_MDerived, _Scalar>> &&
+    derived_from<_YDerived, MatrixBase<_YDerived, _Scalar>>
+void multiplyRowVector(const MatrixBase<_XDerived, _Scalar>& x, const MatrixBase<_MDerived, _Scalar>& A,
+  MatrixBase<_YDerived, _Scalar>& y, const _Scalar& alpha = traits::scalar_traits<_Scalar>::one,
+  const _Scalar& beta = traits::scalar_traits<_Scalar>::zero)
+{
+  const auto& a = A.derived();
+  const auto& xv = x.derived();
+  auto& yv = y.derived();
+  detail::checkVectors(xv, yv, a.rows(), a.cols(), true);
+  if constexpr (backend::CanUseCblas<_MDerived, _XDerived, _YDerived>) {
+    if (backend::useCblas() && backend::gemv(a, xv, yv, alpha, beta, true)) {
+      return;
+    }
+  }
+  const Index n = a.rows();
+  const Index m = a.cols();
+  if (m >= n) {
+    const Index nb = tuning::params().gevmBlockCols;
+    parallel::parallelFor(0, m, parallel::grainFor(n), [&](Index lo, Index hi)
+    {
+      mul::multiplyRowVectorCols<Index>(xv, a, yv, alpha, beta, lo, hi, nb);
+    });
+    return;
+  }
+
+  const Index nChunks = std::clamp<Index>(n * m / tuning::params().parallelMinWork, 1, parallel::numThreads());
+  vector<_Scalar> partial(nChunks * m, traits::scalar_traits<_Scalar>::zero);
+  parallel::parallelFor(0, nChunks, 1, [&](Index lo, Index hi)
+  {
+    for (Index t = lo; t < hi; ++t) {
+      _Scalar* part = partial.data() + t * m;
+      mul::multiplyRowVectorRowsAddTo<Index>(xv, a, part, n * t / nChunks, n * (t + 1) / nChunks);
+    }
+  });
+  parallel::parallelFor(0, m, parallel::coeffWiseGrain(), [&](Index lo, Index hi)
+  {
+    for (Index j = lo; j < hi; ++j) {
+      auto sum = partial[j];
+      for (Index t = 1; t < nChunks; ++t) {
+        sum += partial[t * m + j];
+      }
+      yv[j] = beta == traits::scalar_traits<_Scalar>::zero ? alpha * sum : alpha * sum + beta * yv[j];
+    }
+  });
+}
+
 DISTMAT_BINARY_TFUNC
-_LDerived operator*(const _LDerived& lhs, const MatrixBase<_RDerived, _Scalar>& rhs)
+typename traits::mul_result<_LDerived, _RDerived>::type operator*(const _LDerived& lhs, const MatrixBase<_RDerived, _Scalar>& rhs)
 {
-  CHECK_MUL_DIM(lhs, rhs.derived());
-  _LDerived tmp = _LDerived::zeros(lhs.rows(), rhs.derived().rows());
-  mul::multiplyMatrix<Index>(lhs, rhs.derived(), tmp);
+  using Result = typename traits::mul_result<_LDerived, _RDerived>::type;
+  const auto& r = rhs.derived();
+  CHECK_MUL_DIM(lhs, r);
+  if (r.cols() == 1 || lhs.rows() == 1) {
+    // matrix-vector products are bound by memory bandwidth, not by the flops
+    auto tmp = detail::makeMatrix<Result>(lhs.rows(), r.cols());
+    if (r.cols() == 1) {
+      multiplyVector(lhs, r, tmp);
+    } else {
+      multiplyRowVector(lhs, r, tmp);
+    }
+    return tmp;
+  }
+  if constexpr (backend::CanUseCblas<_LDerived, _RDerived, Result>) {
+    if (backend::useCblas()) {
+      auto tmp = detail::makeMatrix<Result>(lhs.rows(), r.cols());
+      if (backend::gemm(lhs, r, tmp, traits::scalar_traits<_Scalar>::one, traits::scalar_traits<_Scalar>::zero)) {
+        return tmp;
+      }
+    }
+  }
+  Result tmp = Result::zeros(lhs.rows(), r.cols());
+  const auto& tune = tuning::params();
+  if (std::min({lhs.rows(), lhs.cols(), r.cols()}) < tune.gemmBlockedMinSize) {
+    // A small dimension is often fixed at compile time (e.g. `Matrix<S, -1, 3>`),
+    // the kernel then runs on the matrices themselves so its loops over that
+    // dimension have a constant trip count. Rows are still split among threads.
+    parallel::parallelFor(0, lhs.rows(), parallel::grainFor(lhs.cols() * r.cols()), [&](Index lo, Index hi)
+    {
+      mul::multiplyMatrixRows<Index>(lhs, r, tmp, lo, hi);
+    });
+    return tmp;
+  }
+  // row panels of C are independent
+  parallel::parallelFor(0, lhs.rows(), parallel::grainFor(lhs.cols() * r.cols()), [&](Index lo, Index hi)
+  {
+    mul::multiplyMatrixBlocked<Index>(block(lhs, lo, 0, hi - lo, lhs.cols()), r, block(tmp, lo, 0, hi - lo, r.cols()),
+      tune.gemmBlockRows, tune.gemmBlockInner, tune.gemmBlockCols);
+  });
   return tmp;
 }
 
 DISTMAT_TFUNC
-_Derived operator*(const _Scalar& lhs, const MatrixBase<_Derived, _Scalar>& rhs)
+typename traits::eval_result<_Derived>::type operator*(const _Scalar& lhs, const MatrixBase<_Derived, _Scalar>& rhs)
 {
-  _Derived tmp = rhs.derived();
+  typename traits::eval_result<_Derived>::type tmp = rhs.derived();
   tmp.mulByScalar(lhs);
   return tmp;
 }
 
 DISTMAT_TFUNC
-_Derived operator*(const MatrixBase<_Derived, _Scalar>& lhs, const _Scalar& rhs)
+typename traits::eval_result<_Derived>::type operator*(const MatrixBase<_Derived, _Scalar>& lhs, const _Scalar& rhs)
 {
   return rhs * lhs;
 }
 
 DISTMAT_TFUNC
-_Derived operator/(const MatrixBase<_Derived, _Scalar>& lhs, const _Scalar& rhs)
+typename traits::eval_result<_Derived>::type operator/(const MatrixBase<_Derived, _Scalar>& lhs, const _Scalar& rhs)
 {
-  _Derived tmp = lhs.derived();
+  typename traits::eval_result<_Derived>::type tmp = lhs.derived();
   return tmp * (traits::scalar_traits<_Scalar>::one / rhs);
 }
 
 /// \brief Unary operator - as in -A
 DISTMAT_TFUNC
-_Derived operator-(const MatrixBase<_Derived, _Scalar>& mat)
+typename traits::eval_result<_Derived>::type operator-(const MatrixBase<_Derived, _Scalar>& mat)
 {
-  _Derived tmp = mat.derived();
+  typename traits::eval_result<_Derived>::type tmp = mat.derived();
   ranges::for_each(views::iota(Index(0), tmp.size()), [&tmp](Index i)
   {
     tmp[i] = -tmp[i];
@@ -244,6 +448,90 @@ _Derived operator-(const MatrixBase<_Derived, _Scalar>& mat)
   return tmp;
 }
 
+/// \brief `A^k` by exponentiation by squaring.
+/// The powers `A^(2^i)` alternate between two preallocated buffers and the
+/// result is accumulated in place with `MulRightTo`, so no matrix is allocated
+/// inside the loop. Not named `pow`, which would hide `std::pow` from
+/// unqualified scalar calls inside the namespace.
+DISTMAT_TFUNC
+_Derived matrixPower(const MatrixBase<_Derived, _Scalar>& A, unsigned long long k)
+{
+  CHECK_SQUARE(A.derived());
+  const Index n = A.derived().rows();
+  if (k == 0) {
+    return _Derived::eye(n, n);
+  }
+
+  _Derived power = A.derived();
+  auto powerNext = detail::makeMatrix<_Derived>(n, n);
+  auto ret = detail::makeMatrix<_Derived>(n, n);
+  vector<_Scalar> tmp(n);
+  bool isIdentity = true;
+  while (true) {
+    if (k & 1) {
+      if (isIdentity) {
+        ret = power;
+        isIdentity = false;
+      } else {
+        power.MulRightTo(ret, tmp);
+      }
+    }
+    k >>= 1;
+    if (k == 0) {
+      break;
+    }
+    mul::multiplyMatrixTo<Index>(power, power, powerNext);
+    std::swap(power, powerNext);
+  }
+  return ret;
+}
+
+/// \brief Apply the square transform `T` to `X` for `k` times in place, `X = T^k * X`.
+/// When `X` has few columns compared to `T`, `k` products `T * X` are cheaper
+/// than squaring `T`, otherwise the powers `T^(2^i)` are computed as in `matrixPower`
+/// and applied for every set bit of `k`. Either way all buffers are allocated
+/// once before the loop.
+DISTMAT_BINARY_TFUNC
+void applyRepeated(const MatrixBase<_LDerived, _Scalar>& T, MatrixBase<_RDerived, _Scalar>& X, unsigned long long k)
+{
+  const auto& t = T.derived();
+  auto& x = X.derived();
+  CHECK_SQUARE(t);
+  CHECK_MUL_DIM(t, x);
+  const Index n = t.rows();
+  vector<_Scalar> tmp(n);
+
+  Index squarings = 0;
+  for (auto bits = k; bits > 1; bits >>= 1) {
+    ++squarings;
+  }
+  if (x.cols() == 0) {
+    return;
+  }
+  // k products T * X cost k n^2 m, the squarings cost at least log2(k) n^3,
+  // compared without forming k m, which may not fit
+  if (k <= squarings * n / x.cols()) {
+    for (unsigned long long i = 0; i < k; ++i) {
+      t.MulLeftTo(x, tmp);
+    }
+    return;
+  }
+
+  _LDerived power = t;
+  auto powerNext = detail::makeMatrix<_LDerived>(n, n);
+  while (true) {
+    if (k & 1) {
+      power.MulLeftTo(x, tmp);
+    }
+    k >>= 1;
+    if (k == 0) {
+      break;
+    }
+    mul::multiplyMatrixTo<Index>(power, power, powerNext);
+    std::swap(power, powerNext);
+  }
+}
+
 DISTMAT_TFUNC
 std::ostream& operator<<(std::ostream& out, const MatrixBase<_Derived, _Scalar>& mat)
 {
@@ -252,7 +540,7 @@ std::ostream& operator<<(std::ostream& out, const MatrixBase<_Derived, _Scalar>&
     for (Index col = 0; col < der.cols(); ++col) {
       out << der(row, col) << " ";
     }
-    out << endl;
+    out << '\n';
   }
   return out;
 }
@@ -262,6 +550,11 @@ std::ostream& operator<<(std::ostream& out, const MatrixBase<_Derived, _Scalar>&
 template<typename T>
   concept IsScalar = std::regular<T>;
 
+/// A matrix or an expression such as `TransposeView`.
+template<typename T>
+  concept IsMatrixExpression = requires { typename T::scalar_type; }
+  && derived_from<T, MatrixBase<T, typename T::scalar_type>>;
+
 template<typename T>
   concept Is_rows_Implemented = !same_as<decltype(&T::rows), decltype(&T::Base::rows)>;
 template<typename T>
@@ -1,22 +1,24 @@
 #pragma once
 #include <functional>
+#include <algorithm>
 
 namespace mul {
 
 /// A = A * B
-/// A and B are both nxn matrices
-/// \param tmp      a n-dimension vector for temporal storage of middle results, must be zero before calling
+/// A is a mxn matrix and B is a nxn matrix
+/// \param tmp      a n-dimension vector for temporal storage of middle results
 template<typename Index>
 constexpr void multiplyMatrixRightToInplace(auto& A, auto& B, auto& tmp)
 {
-  const Index n = A.rows();
-  for (Index i = 0; i < n; i++) {
+  const Index m = A.rows();
+  const Index n = A.cols();
+  for (Index i = 0; i < m; i++) {
     for (Index j = 0; j < n; j++) { // initialize temporal vector
       tmp[j] = 0;
     }
     for (Index j = 0; j < n; j++) { // evaluate some line, and save to vector
-      for (Index m = 0; m < n; m++) {
-        tmp[j] += A(i, m) * B(m, j);
+      for (Index k = 0; k < n; k++) {
+        tmp[j] += A(i, k) * B(k, j);
       }
     }
     for (Index j = 0; j < n; j++) { // assign the vector to the matrix
@@ -26,18 +28,20 @@ constexpr void multiplyMatrixRightToInplace(auto& A, auto& B, auto& tmp)
 }
 
 /// A = B * A
+/// A is a nxm matrix and B is a nxn matrix
 /// \see multiplyMatrixRightToInplace
 template<typename Index>
 constexpr void multiplyMatrixLeftToInplace(auto& A, auto& B, auto& tmp)
 {
   const Index n = A.rows();
-  for (Index j = 0; j < n; j++) {
+  const Index m = A.cols();
+  for (Index j = 0; j < m; j++) {
     for (Index i = 0; i < n; i++) {
       tmp[i] = 0;
     }
     for (Index i = 0; i < n; i++) {
-      for (Index m = 0; m < n; m++) {
-        tmp[i] += B(i, m) * A(m, j);
+      for (Index k = 0; k < n; k++) {
+        tmp[i] += B(i, k) * A(k, j);
       }
     }
     for (Index i = 0; i < n; i++) {
@@ -65,4 +69,333 @@ constexpr void multiplyMatrix(auto& A, auto& B, auto& C)
   }
 }
 
+/// C[lo:hi, :] += A[lo:hi, :] * B
+/// Same loops as `multiplyMatrix` restricted to a range of rows, in i-k-j
+/// order. Takes the matrices themselves instead of `Block` views, so that
+/// dimensions known at compile time stay known.
+template<class Index>
+constexpr void multiplyMatrixRows(const auto& A, const auto& B, auto& C, Index lo, Index hi)
+{
+  const Index m = A.cols();
+  const Index s = B.cols();
+  for (Index i = lo; i < hi; ++i) {
+    for (Index k = 0; k < m; ++k) {
+      const auto a = A(i, k);
+      for (Index j = 0; j < s; ++j) {
+        C(i, j) += a * B(k, j);
+      }
+    }
+  }
+}
+
+/// C += A * B, tiled so that a `kb x nb` panel of B and a `mb x nb` panel of C
+/// stay in cache while a `mb x kb` tile of A is streamed against them.
+/// \param A nxm matrix
+/// \param B mxs matrix
+/// \param C nxs matrix
+/// \param mb,kb,nb tile sizes, see `tuning::Params`
+template<class Index>
+constexpr void multiplyMatrixBlocked(const auto& A, const auto& B, auto&& C, Index mb, Index kb, Index nb)
+{
+  const Index n = A.rows();
+  const Index m = A.cols();
+  const Index s = B.cols();
+  for (Index j0 = 0; j0 < s; j0 += nb) {
+    const Index j1 = std::min(j0 + nb, s);
+    for (Index k0 = 0; k0 < m; k0 += kb) {
+      const Index k1 = std::min(k0 + kb, m);
+      for (Index i0 = 0; i0 < n; i0 += mb) {
+        const Index i1 = std::min(i0 + mb, n);
+        for (Index i = i0; i < i1; ++i) {
+          for (Index k = k0; k < k1; ++k) {
+            const auto a = A(i, k);
+            for (Index j = j0; j < j1; ++j) {
+              C(i, j) += a * B(k, j);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+/// C = A * B, the previous content of C is overwritten.
+/// Loops in i-k-j order like `multiplyMatrixSubTo`.
+/// \param A nxm matrix
+/// \param B mxs matrix
+/// \param C nxs matrix, must not alias A or B
+template<class Index>
+constexpr void multiplyMatrixTo(const auto& A, const auto& B, auto&& C)
+{
+  const Index n = A.rows();
+  const Index m = A.cols();
+  const Index s = B.cols();
+  for (Index i = 0; i < n; ++i) {
+    for (Index j = 0; j < s; ++j) {
+      C(i, j) = 0;
+    }
+    for (Index k = 0; k < m; ++k) {
+      const auto a = A(i, k);
+      for (Index j = 0; j < s; ++j) {
+        C(i, j) += a * B(k, j);
+      }
+    }
+  }
+}
+
+/// C -= A * B
+/// Loops in i-k-j order so that the innermost loop walks rows of `B` and `C`,
+/// which are contiguous for row major storage. Used for trailing matrix updates
+/// of the blocked factorizations.
+/// \param A nxm matrix
+/// \param B mxs matrix
+/// \param C nxs matrix
+template<class Index>
+constexpr void multiplyMatrixSubTo(const auto& A, const auto& B, auto&& C)
+{
+  const Index n = A.rows();
+  const Index m = A.cols();
+  const Index s = B.cols();
+  for (Index i = 0; i < n; ++i) {
+    for (Index k = 0; k < m; ++k) {
+      const auto a = A(i, k);
+      for (Index j = 0; j < s; ++j) {
+        C(i, j) -= a * B(k, j);
+      }
+    }
+  }
+}
+
+/// C -= A * B^T
+/// Every coefficient is a dot product of two rows, so both operands are read
+/// contiguously for row major storage.
+/// \param A nxm matrix
+/// \param B sxm matrix
+/// \param C nxs matrix
+template<class Index>
+constexpr void multiplyMatrixTransposedSubTo(const auto& A, const auto& B, auto&& C)
+{
+  const Index n = A.rows();
+  const Index m = A.cols();
+  const Index s = B.rows();
+  if (m == 0) {
+    return;
+  }
+  for (Index i = 0; i < n; ++i) {
+    for (Index j = 0; j < s; ++j) {
+      auto sum = A(i, 0) * B(j, 0);
+      for (Index k = 1; k < m; ++k) {
+        sum += A(i, k) * B(j, k);
+      }
+      C(i, j) -= sum;
+    }
+  }
+}
+
+/// C[lo:hi, :] = lower triangle of (A * A^T)[lo:hi, :], the upper triangle of
+/// those rows is not written (SYRK). Only half of the products are computed.
+/// A `kb` wide panel of the columns of A is packed transposed into `pack`, so
+/// the innermost loop walks a row of `pack` and of `C` like `multiplyMatrixRows`.
+/// \param A    nxm matrix
+/// \param C    nxn matrix, must not alias A
+/// \param pack storage of at least `kb * hi` coefficients
+template<class Index>
+constexpr void multiplyTransposedLowerRows(const auto& A, auto& C, Index lo, Index hi, Index kb, auto& pack)
+{
+  const Index m = A.cols();
+  for (Index i = lo; i < hi; ++i) {
+    for (Index j = 0; j <= i; ++j) {
+      C(i, j) = 0;
+    }
+  }
+  for (Index k0 = 0; k0 < m; k0 += kb) {
+    const Index k1 = std::min(k0 + kb, m);
+    for (Index j = 0; j < hi; ++j) {
+      for (Index k = k0; k < k1; ++k) {
+        pack[(k - k0) * hi + j] = A(j, k);
+      }
+    }
+    for (Index i = lo; i < hi; ++i) {
+      for (Index k = k0; k < k1; ++k) {
+        const auto a = A(i, k);
+        const auto* p = &pack[(k - k0) * hi];
+        for (Index j = 0; j <= i; ++j) {
+          C(i, j) += a * p[j];
+        }
+      }
+    }
+  }
+}
+
+/// C[lo:hi, :] = lower triangle of (A^T * A)[lo:hi, :], the upper triangle of
+/// those rows is not written. Rank-1 updates with the rows of A, tiled so that
+/// a `mb x nb` tile of C stays in cache while all rows of A stream past it.
+/// \param A nxm matrix
+/// \param C mxm matrix, must not alias A
+template<class Index>
+constexpr void multiplyTransposedLeftLowerRows(const auto& A, auto& C, Index lo, Index hi, Index mb, Index nb)
+{
+  const Index n = A.rows();
+  for (Index i = lo; i < hi; ++i) {
+    for (Index j = 0; j <= i; ++j) {
+      C(i, j) = 0;
+    }
+  }
+  for (Index i0 = lo; i0 < hi; i0 += mb) {
+    const Index i1 = std::min(i0 + mb, hi);
+    for (Index j0 = 0; j0 < i1; j0 += nb) {
+      const Index j1 = std::min(j0 + nb, i1);
+      for (Index r = 0; r < n; ++r) {
+        for (Index i = std::max(i0, j0); i < i1; ++i) {
+          const auto a = A(r, i);
+          const Index jEnd = std::min(j1, i + 1);
+          for (Index j = j0; j < jEnd; ++j) {
+            C(i, j) += a * A(r, j);
+          }
+        }
+      }
+    }
+  }
+}
+
+/// C[lo:hi, :] = T[lo:hi, :] * B for a triangular T (TRMM). Only the `lower`
+/// or upper triangle of T is read and the zero half is skipped, which halves
+/// the work. With `unitDiag` the diagonal of T is not read and taken as one.
+/// Tiled like `multiplyMatrixBlocked`.
+/// \param T nxn matrix
+/// \param B nxs matrix
+/// \param C nxs matrix, must not alias B
+template<class Index, bool lower, bool unitDiag>
+constexpr void multiplyTriangularRows(const auto& T, const auto& B, auto& C, Index lo, Index hi, Index mb, Index kb, Index nb)
+{
+  const Index n = T.rows();
+  const Index s = B.cols();
+  for (Index i = lo; i < hi; ++i) {
+    for (Index j = 0; j < s; ++j) {
+      C(i, j) = unitDiag ? B(i, j) : 0;
+    }
+  }
+  for (Index j0 = 0; j0 < s; j0 += nb) {
+    const Index j1 = std::min(j0 + nb, s);
+    for (Index k0 = 0; k0 < n; k0 += kb) {
+      const Index k1 = std::min(k0 + kb, n);
+      for (Index i0 = lo; i0 < hi; i0 += mb) {
+        const Index i1 = std::min(i0 + mb, hi);
+        for (Index i = i0; i < i1; ++i) {
+          const Index kBegin = lower ? k0 : std::max(k0, unitDiag ? i + 1 : i);
+          const Index kEnd = lower ? std::min(k1, unitDiag ? i : i + 1) : k1;
+          for (Index k = kBegin; k < kEnd; ++k) {
+            const auto t = T(i, k);
+            for (Index j = j0; j < j1; ++j) {
+              C(i, j) += t * B(k, j);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+/// C[lo:hi, :] = S[lo:hi, :] * B for a symmetric S of which only the `lower`
+/// or upper triangle is read (SYMM), the other one may hold anything.
+/// Tiled like `multiplyMatrixBlocked`.
+/// \param S nxn matrix
+/// \param B nxs matrix
+/// \param C nxs matrix, must not alias B
+template<class Index, bool lower>
+constexpr void multiplySymmetricRows(const auto& S, const auto& B, auto& C, Index lo, Index hi, Index mb, Index kb, Index nb)
+{
+  const Index n = S.rows();
+  const Index s = B.cols();
+  for (Index i = lo; i < hi; ++i) {
+    for (Index j = 0; j < s; ++j) {
+      C(i, j) = 0;
+    }
+  }
+  for (Index j0 = 0; j0 < s; j0 += nb) {
+    const Index j1 = std::min(j0 + nb, s);
+    for (Index k0 = 0; k0 < n; k0 += kb) {
+      const Index k1 = std::min(k0 + kb, n);
+      for (Index i0 = lo; i0 < hi; i0 += mb) {
+        const Index i1 = std::min(i0 + mb, hi);
+        for (Index i = i0; i < i1; ++i) {
+          for (Index k = k0; k < k1; ++k) {
+            const auto a = (lower ? k <= i : k >= i) ? S(i, k) : S(k, i);
+            for (Index j = j0; j < j1; ++j) {
+              C(i, j) += a * B(k, j);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+/// y[lo:hi] = alpha * A[lo:hi, :] * x + beta * y[lo:hi] (GEMV)
+/// Every row of A is read once and reduced against x with four independent
+/// partial sums, which breaks the dependency chain of the dot product so that
+/// it can be vectorized. With `beta == 0`, y is only written.
+/// \param A nxm matrix
+/// \param x vector of m coefficients, accessed with `operator[]`
+/// \param y vector of n coefficients, must not alias x
+template<class Index>
+constexpr void multiplyVectorRows(const auto& A, const auto& x, auto& y, auto alpha, auto beta, Index lo, Index hi)
+{
+  const Index m = A.cols();
+  for (Index i = lo; i < hi; ++i) {
+    decltype(alpha) s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    Index k = 0;
+    for (; k + 4 <= m; k += 4) {
+      s0 += A(i, k) * x[k];
+      s1 += A(i, k + 1) * x[k + 1];
+      s2 += A(i, k + 2) * x[k + 2];
+      s3 += A(i, k + 3) * x[k + 3];
+    }
+    for (; k < m; ++k) {
+      s0 += A(i, k) * x[k];
+    }
+    const auto dot = (s0 + s1) + (s2 + s3);
+    y[i] = beta == 0 ? alpha * dot : alpha * dot + beta * y[i];
+  }
+}
+
+/// y[lo:hi] = alpha * x * A[:, lo:hi] + beta * y[lo:hi] (GEVM, x and y are row vectors)
+/// The band of columns is processed in `nb` wide tiles: the tile of y stays in
+/// cache while the rows of the tile of A stream past it, so A is read once.
+/// \param x vector of n coefficients
+/// \param A nxm matrix
+/// \param y vector of m coefficients, must not alias x
+template<class Index>
+constexpr void multiplyRowVectorCols(const auto& x, const auto& A, auto& y, auto alpha, auto beta, Index lo, Index hi, Index nb)
+{
+  const Index n = A.rows();
+  for (Index j = lo; j < hi; ++j) {
+    y[j] = beta == 0 ? 0 : beta * y[j];
+  }
+  for (Index j0 = lo; j0 < hi; j0 += nb) {
+    const Index j1 = std::min(j0 + nb, hi);
+    for (Index i = 0; i < n; ++i) {
+      const auto a = alpha * x[i];
+      for (Index j = j0; j < j1; ++j) {
+        y[j] += a * A(i, j);
+      }
+    }
+  }
+}
+
+/// y += x[lo:hi] * A[lo:hi, :]
+/// Partial GEVM over a band of rows, for matrices too narrow to split by columns.
+/// \see multiplyRowVectorCols
+template<class Index>
+constexpr void multiplyRowVectorRowsAddTo(const auto& x, const auto& A, auto& y, Index lo, Index hi)
+{
+  const Index m = A.cols();
+  for (Index i = lo; i < hi; ++i) {
+    const auto a = x[i];
+    for (Index j = 0; j < m; ++j) {
+      y[j] += a * A(i, j);
+    }
+  }
+}
+
 } // namespace mul
\ No newline at end of file
@@ -0,0 +1,230 @@
+#pragma once
+#include "Type.hpp"
+#include "Topology.hpp"
+#include "Parallel.hpp"
+
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+#include <cstdint>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace distmat
+{
+namespace numa
+{
+
+/// Page placement of a newly allocated dynamic matrix.
+/// Pages are placed by the first write (first-touch) on Linux, and
+/// `util::default_init_allocator` leaves them untouched, so the placement is
+/// done by writing zeros from threads running on the desired node. Memory
+/// recycled by the allocator was already touched and keeps its node, such
+/// pages are then migrated with `move_pages(2)`.
+enum class Policy {
+  None,         ///< leave the first touch to whoever writes the matrix first
+  Interleave,   ///< pages round-robin over the NUMA nodes
+  RowBlock,     ///< one contiguous block of rows per NUMA node
+  FirstTouch,   ///< every chunk touched by the pinned `parallelFor` worker that owns it,
+                ///< kernels read it locally when `parallel::setPinThreads(true)`
+};
+
+namespace detail {
+  inline std::atomic<Policy>& policy()
+  {
+    static std::atomic<Policy> p{Policy::None};
+    return p;
+  }
+  inline std::atomic<Index>& minBytes()
+  {
+    static std::atomic<Index> bytes{Index(1) << 22};
+    return bytes;
+  }
+
+  inline Index pageBytes()
+  {
+#ifdef __linux__
+    return std::max<long>(sysconf(_SC_PAGESIZE), 1);
+#else
+    return 4096;
+#endif
+  }
+
+  /// Run `f(node)` on one thread per NUMA node, pinned to that node.
+  template<typename F>
+  void forEachNode(F&& f)
+  {
+    const auto& topo = topology::get();
+    vector<std::jthread> workers;
+    for (Index node = 0; node < topo.numNodes(); ++node) {
+      workers.emplace_back([&f, &topo, node]
+      {
+        topology::pinCurrentThread(topo.nodeCpus[node]);
+        f(node);
+      });
+    }
+  }
+
+  /// Node holding `cpu`, 0 if it is not in the topology.
+  inline Index nodeOfCpu(unsigned cpu)
+  {
+    const auto& topo = topology::get();
+    for (Index node = 0; node < topo.numNodes(); ++node) {
+      const auto& cpus = topo.nodeCpus[node];
+      if (std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) {
+        return node;
+      }
+    }
+    return 0;
+  }
+
+  /// Move every page overlapping `[data, data + bytes)` to `target(offset)`,
+  /// the node of the byte at `offset` from `data`. Returns the number of pages
+  /// left on another node, all of them if `move_pages` fails altogether.
+  template<typename F>
+  Index movePages([[maybe_unused]] const void* data, [[maybe_unused]] Index bytes, [[maybe_unused]] F&& target)
+  {
+#ifdef __linux__
+    constexpr Index batch = 1024;
+    const Index pageBytes = detail::pageBytes();
+    const auto address = reinterpret_cast<std::uintptr_t>(data);
+    const std::uintptr_t first = address - address % pageBytes;
+    const Index count = (address + bytes - first + pageBytes - 1) / pageBytes;
+    void* pages[batch];
+    int nodes[batch];
+    int status[batch];
+    Index misplaced = 0;
+    for (Index p0 = 0; p0 < count; p0 += batch) {
+      const Index n = std::min(batch, count - p0);
+      for (Index p = 0; p < n; ++p) {
+        const std::uintptr_t page = first + (p0 + p) * pageBytes;
+        pages[p] = reinterpret_cast<void*>(page);
+        nodes[p] = int(target(std::max(page, address) - address));
+      }
+      if (syscall(SYS_move_pages, 0, n, pages, nodes, status, MPOL_MF_MOVE) < 0
+          && syscall(SYS_move_pages, 0, n, pages, nullptr, status, 0) < 0) {
+        misplaced += n;
+        continue;
+      }
+      for (Index p = 0; p < n; ++p) {
+        misplaced += status[p] != nodes[p];
+      }
+    }
+    return misplaced;
+#else
+    return 0;
+#endif
+  }
+} // namespace detail
+
+/// Policy applied by `Matrix(rows, cols)` to matrices of at least `minBytes()` bytes.
+inline Policy policy() { return detail::policy().load(std::memory_order_relaxed); }
+inline Index minBytes() { return detail::minBytes().load(std::memory_order_relaxed); }
+inline void setPolicy(Policy p, Index minBytes = Index(1) << 22)
+{
+  detail::policy().store(p, std::memory_order_relaxed);
+  detail::minBytes().store(minBytes, std::memory_order_relaxed);
+}
+
+/// NUMA node of the page holding `address`, -1 if it is unknown (no Linux or
+/// no NUMA support in the kernel).
+inline int nodeOf([[maybe_unused]] const void* address)
+{
+#ifdef __linux__
+  int node = -1;
+  if (syscall(SYS_get_mempolicy, &node, nullptr, 0, address, MPOL_F_NODE | MPOL_F_ADDR) == 0) {
+    return node;
+  }
+#endif
+  return -1;
+}
+
+/// Place the `size` coefficients at `data`, a row major matrix with `cols`
+/// columns, according to `p`, and overwrite them with zeros. Pages that the
+/// zeros did not bring to their node, because the allocator handed out memory
+/// that was touched before, are migrated afterwards. Returns the number of
+/// pages still on another node, e.g. when `move_pages` is not permitted.
+/// Only trivial scalars are placed, other types are already touched by their
+/// constructors. A `FirstTouch` matrix of a single chunk is left on the node
+/// of the calling thread.
+template<typename Scalar>
+Index place(Scalar* data, Index size, Index cols, Policy p)
+{
+  if constexpr (std::is_trivially_default_constructible_v<Scalar>) {
+    if (p == Policy::None || size == 0) {
+      return 0;
+    }
+    const Index nodes = topology::get().numNodes();
+    const Index rows = size / std::max<Index>(cols, 1);
+    const Index pageBytes = detail::pageBytes();
+    const Index pageSize = std::max<Index>(pageBytes / sizeof(Scalar), 1);
+    // whole pages start at the first page boundary after `data`
+    const auto address = reinterpret_cast<std::uintptr_t>(data);
+    const Index headBytes = (pageBytes - address % pageBytes) % pageBytes;
+    const Index head = std::min(size, (headBytes + sizeof(Scalar) - 1) / sizeof(Scalar));
+    // the chunks of `parallelFor`
+    const Index grain = std::max<Index>(parallel::coeffWiseGrain(), 1);
+    const Index nChunks = std::min<Index>(parallel::numThreads(), (size + grain - 1) / grain);
+    if (p == Policy::FirstTouch) {
+      parallel::parallelFor(0, size, grain, [data](Index lo, Index hi)
+      {
+        std::fill(data + lo, data + hi, Scalar{});
+      }, true);
+    } else if (p == Policy::RowBlock || nodes == 1) {
+      detail::forEachNode([=](Index node)
+      {
+        const Index lo = rows * node / nodes * cols;
+        const Index hi = node + 1 == nodes ? size : rows * (node + 1) / nodes * cols;
+        std::fill(data + lo, data + hi, Scalar{});
+      });
+    } else {
+      detail::forEachNode([=](Index node)
+      {
+        if (node == 0) {
+          std::fill(data, data + head, Scalar{});
+        }
+        for (Index lo = head + node * pageSize; lo < size; lo += nodes * pageSize) {
+          std::fill(data + lo, data + std::min(size, lo + pageSize), Scalar{});
+        }
+      });
+    }
+    if (nodes == 1 || (p == Policy::FirstTouch && nChunks <= 1)) {
+      return 0;
+    }
+    // node that the coefficient `i` belongs to, as written above
+    return detail::movePages(data, size * sizeof(Scalar), [=](Index offset) -> Index
+    {
+      const Index i = offset / sizeof(Scalar);
+      if (p == Policy::FirstTouch) {
+        const Index t = ((i + 1) * nChunks + size - 1) / size - 1;
+        return detail::nodeOfCpu(topology::workerCpu(t, nChunks));
+      }
+      if (p == Policy::RowBlock) {
+        Index node = nodes - 1;
+        while (node > 0 && rows * node / nodes * cols > i) {
+          --node;
+        }
+        return node;
+      }
+      return i < head ? 0 : (i - head) / pageSize % nodes;
+    });
+  }
+  return 0;
+}
+
+/// Place with the global `policy()` if the matrix is large enough.
+template<typename Scalar>
+Index place(Scalar* data, Index size, Index cols)
+{
+  if (size * sizeof(Scalar) >= minBytes()) {
+    return place(data, size, cols, policy());
+  }
+  return 0;
+}
+
+} // namespace numa
+} // namespace distmat
@@ -0,0 +1,112 @@
+#pragma once
+#include "Type.hpp"
+#include "Topology.hpp"
+#include "Tuning.hpp"
+
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+
+namespace distmat
+{
+namespace parallel
+{
+
+namespace detail {
+  inline std::atomic<unsigned>& threadCount()
+  {
+    static std::atomic<unsigned> count{std::max(1U, std::thread::hardware_concurrency())};
+    return count;
+  }
+  inline std::atomic<bool>& pinThreads()
+  {
+    static std::atomic<bool> pin{false};
+    return pin;
+  }
+} // namespace detail
+
+/// Number of workers used by `parallelFor`, defaults to the hardware concurrency.
+inline unsigned numThreads() { return detail::threadCount().load(std::memory_order_relaxed); }
+inline void setNumThreads(unsigned n) { detail::threadCount().store(std::max(1U, n), std::memory_order_relaxed); }
+
+/// Whether `parallelFor` pins worker `t` to `topology::workerCpu(t, n)`.
+/// Chunk `t` of the same range is then always processed on the same CPU, so
+/// it reads the memory it placed with `numa::Policy::FirstTouch`.
+inline bool pinThreads() { return detail::pinThreads().load(std::memory_order_relaxed); }
+inline void setPinThreads(bool pin) { detail::pinThreads().store(pin, std::memory_order_relaxed); }
+
+/// Grain size so that a task has at least `minWorkPerTask` units of work when
+/// every index costs `workPerIndex`. Tiny loops then stay on the calling thread.
+inline Index grainFor(Index workPerIndex, Index minWorkPerTask = tuning::params().parallelMinWork)
+{
+  return std::max<Index>(1, minWorkPerTask / std::max<Index>(workPerIndex, 1));
+}
+
+/// Grain of the coefficient-wise kernels. `numa::Policy::FirstTouch` uses it
+/// too, so that both split a matrix into the same chunks.
+inline Index coeffWiseGrain() { return tuning::params().coeffWiseGrain; }
+
+/// Split `[begin, end)` into at most `numThreads()` contiguous chunks of at
+/// least `grain` indices and call `f(lo, hi)` on each chunk concurrently.
+/// Chunk `t` is always handled by worker `t`, the first chunk runs on the
+/// calling thread unless the workers are pinned.
+template<typename F>
+void parallelFor(Index begin, Index end, Index grain, F&& f, bool pin)
+{
+  if (begin >= end) {
+    return;
+  }
+  const Index n = end - begin;
+  const Index nChunks = std::min<Index>(numThreads(), (n + std::max<Index>(grain, 1) - 1) / std::max<Index>(grain, 1));
+  if (nChunks <= 1) {
+    f(begin, end);
+    return;
+  }
+
+  auto chunkBegin = [=](Index t) { return begin + n * t / nChunks; };
+  vector<std::jthread> workers;
+  workers.reserve(nChunks);
+  for (Index t = pin ? 0 : 1; t < nChunks; ++t) {
+    workers.emplace_back([&f, pin, t, nChunks, lo = chunkBegin(t), hi = chunkBegin(t + 1)]
+    {
+      if (pin) {
+        topology::pinCurrentThread({topology::workerCpu(t, nChunks)});
+      }
+      f(lo, hi);
+    });
+  }
+  if (!pin) {
+    f(chunkBegin(0), chunkBegin(1));
+  }
+}
+
+template<typename F>
+void parallelFor(Index begin, Index end, Index grain, F&& f)
+{
+  parallelFor(begin, end, grain, std::forward<F>(f), pinThreads());
+}
+
+/// `parallelFor` over the rows `[0, n)` of a lower triangular loop, where row
+/// `i` costs `(i + 1) * workPerCoeff`. The rows are split at `n * sqrt(t / T)`,
+/// so that the chunks have about the same work instead of the same length.
+/// Loops over an upper triangle map their rows with `n - hi, n - lo`.
+template<typename F>
+void parallelForTriangular(Index n, Index workPerCoeff, F&& f)
+{
+  const Index work = n * (n + 1) / 2 * std::max<Index>(workPerCoeff, 1);
+  const Index nChunks = std::clamp<Index>(work / std::max<Index>(tuning::params().parallelMinWork, 1), 1, numThreads());
+  auto chunkBegin = [=](Index t)
+  {
+    return t == nChunks ? n : Index(double(n) * std::sqrt(double(t) / double(nChunks)));
+  };
+  parallelFor(0, nChunks, 1, [&](Index lo, Index hi)
+  {
+    for (Index t = lo; t < hi; ++t) {
+      f(chunkBegin(t), chunkBegin(t + 1));
+    }
+  });
+}
+
+} // namespace parallel
+} // namespace distmat
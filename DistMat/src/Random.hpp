@@ -0,0 +1,204 @@
+#pragma once
+#include "Type.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <type_traits>
+
+namespace distmat
+{
+namespace rng
+{
+
+/// \brief Philox4x32-10 counter-based generator (Salmon et al., SC'11).
+/// The 128 random bits of a block are a pure function of the block counter
+/// and the key, so any block can be generated independently of the others.
+/// `generate` computes a batch of consecutive blocks lane by lane, which lets
+/// the compiler vectorize the rounds.
+class Philox4x32 {
+public:
+  using Block = std::array<std::uint32_t, 4>;
+  static constexpr Index batch = 8;
+
+  constexpr explicit Philox4x32(std::uint64_t key) : key_{std::uint32_t(key), std::uint32_t(key >> 32)} {}
+
+  /// Bits of the block with the given 128 bit counter.
+  constexpr Block operator()(Block counter) const
+  {
+    std::uint32_t k0 = key_[0];
+    std::uint32_t k1 = key_[1];
+    for (int round = 0; round < 10; ++round) {
+      counter = this->round(counter, k0, k1);
+      k0 += W0;
+      k1 += W1;
+    }
+    return counter;
+  }
+
+  /// `out[b]` = bits of block `first + b` for `b < count <= batch`.
+  constexpr void generate(std::uint64_t first, Index count, Block* out) const
+  {
+    std::uint32_t c0[batch], c1[batch], c2[batch], c3[batch];
+    for (Index b = 0; b < batch; ++b) {
+      c0[b] = std::uint32_t(first + b);
+      c1[b] = std::uint32_t((first + b) >> 32);
+      c2[b] = 0;
+      c3[b] = 0;
+    }
+    std::uint32_t k0 = key_[0];
+    std::uint32_t k1 = key_[1];
+    for (int round = 0; round < 10; ++round) {
+      for (Index b = 0; b < batch; ++b) {
+        const std::uint64_t p0 = std::uint64_t(M0) * c0[b];
+        const std::uint64_t p1 = std::uint64_t(M1) * c2[b];
+        const std::uint32_t n0 = std::uint32_t(p1 >> 32) ^ c1[b] ^ k0;
+        const std::uint32_t n2 = std::uint32_t(p0 >> 32) ^ c3[b] ^ k1;
+        c1[b] = std::uint32_t(p1);
+        c3[b] = std::uint32_t(p0);
+        c0[b] = n0;
+        c2[b] = n2;
+      }
+      k0 += W0;
+      k1 += W1;
+    }
+    for (Index b = 0; b < count; ++b) {
+      out[b] = {c0[b], c1[b], c2[b], c3[b]};
+    }
+  }
+
+private:
+  static constexpr std::uint32_t M0 = 0xD2511F53;
+  static constexpr std::uint32_t M1 = 0xCD9E8D57;
+  static constexpr std::uint32_t W0 = 0x9E3779B9;
+  static constexpr std::uint32_t W1 = 0xBB67AE85;
+
+  static constexpr Block round(const Block& c, std::uint32_t k0, std::uint32_t k1)
+  {
+    const std::uint64_t p0 = std::uint64_t(M0) * c[0];
+    const std::uint64_t p1 = std::uint64_t(M1) * c[2];
+    return {std::uint32_t(p1 >> 32) ^ c[1] ^ k0, std::uint32_t(p1), std::uint32_t(p0 >> 32) ^ c[3] ^ k1, std::uint32_t(p0)};
+  }
+
+  std::array<std::uint32_t, 2> key_;
+};
+
+namespace detail {
+  /// Uniform in [0, 1) with all the bits of the mantissa.
+  template<typename Scalar>
+  constexpr Scalar toUnit(std::uint32_t hi, std::uint32_t lo)
+  {
+    if constexpr (std::is_same_v<Scalar, float>) {
+      return float(hi >> 8) * 0x1.0p-24F;
+    } else {
+      return Scalar(((std::uint64_t(hi) << 32) | lo) >> 11) * Scalar(0x1.0p-53);
+    }
+  }
+} // namespace detail
+
+/// Uniform coefficients in `[a, b)` for `a < b`, or in `[a, b]` for integers.
+/// `a + (b - a) * u` may round up to `b` for `u` close to 1, such values are
+/// clamped to the largest scalar below `b`. Integers are scaled by a
+/// multiply-shift of 32 random bits, so `b - a` must be less than 2^32, with a
+/// bias below `(b - a) / 2^32`.
+template<typename Scalar>
+struct Uniform {
+  Scalar a = 0;
+  Scalar b = 1;
+
+  /// Coefficients made from the 128 bits of a block.
+  static constexpr Index perBlock = std::is_floating_point_v<Scalar> && !std::is_same_v<Scalar, float> ? 2 : 4;
+
+  void operator()(const Philox4x32::Block& bits, Scalar* out) const
+  {
+    if constexpr (std::is_floating_point_v<Scalar>) {
+      const Scalar last = std::nextafter(b, a);
+      for (Index i = 0; i < perBlock; ++i) {
+        const auto u = perBlock == 4 ? detail::toUnit<Scalar>(bits[i], 0) : detail::toUnit<Scalar>(bits[2 * i], bits[2 * i + 1]);
+        out[i] = std::min(a + (b - a) * u, last);
+      }
+    } else {
+      const std::uint64_t range = std::uint64_t(b - a) + 1;
+      for (Index i = 0; i < perBlock; ++i) {
+        out[i] = Scalar(a + Scalar((range * bits[i]) >> 32));
+      }
+    }
+  }
+};
+
+/// Normal coefficients with the given mean and standard deviation, by the
+/// Box-Muller transform of pairs of uniform numbers.
+template<typename Scalar>
+struct Normal {
+  static_assert(std::is_floating_point_v<Scalar>, "normal coefficients must be floating point");
+  Scalar mean = 0;
+  Scalar stddev = 1;
+
+  static constexpr Index perBlock = std::is_same_v<Scalar, float> ? 4 : 2;
+
+  void operator()(const Philox4x32::Block& bits, Scalar* out) const
+  {
+    constexpr Index pairs = perBlock / 2;
+    for (Index p = 0; p < pairs; ++p) {
+      Scalar u1 = 0;
+      Scalar u2 = 0;
+      if constexpr (pairs == 2) {
+        u1 = detail::toUnit<Scalar>(bits[2 * p], 0);
+        u2 = detail::toUnit<Scalar>(bits[2 * p + 1], 0);
+      } else {
+        u1 = detail::toUnit<Scalar>(bits[0], bits[1]);
+        u2 = detail::toUnit<Scalar>(bits[2], bits[3]);
+      }
+      // 1 - u1 is in (0, 1], so the logarithm is finite
+      const Scalar r = std::sqrt(Scalar(-2) * std::log(Scalar(1) - u1));
+      const Scalar theta = Scalar(2) * std::numbers::pi_v<Scalar> * u2;
+      out[2 * p] = mean + stddev * r * std::cos(theta);
+      out[2 * p + 1] = mean + stddev * r * std::sin(theta);
+    }
+  }
+};
+
+/// Distributions turn the bits of a Philox block into `perBlock` coefficients.
+template<typename D, typename Scalar>
+  concept Distribution = requires (const D& d, const Philox4x32::Block& bits, Scalar* out) {
+    { D::perBlock } -> convertible_to<Index>;
+    d(bits, out);
+  };
+
+/// \brief Fill `mat` with coefficients of `distribution`.
+/// Coefficient `i` (row major) comes from Philox block `i / perBlock` keyed by
+/// `seed`, so the result only depends on the seed and the shape, not on the
+/// number of threads that generated it. Blocks are split among the threads
+/// and computed in batches of `Philox4x32::batch`.
+template<typename Scalar, typename D>
+  requires Distribution<D, Scalar>
+void generate(auto& mat, const D& distribution, std::uint64_t seed)
+{
+  constexpr Index perBlock = D::perBlock;
+  constexpr Index batch = Philox4x32::batch;
+  const Index size = mat.size();
+  const Index blocks = (size + perBlock - 1) / perBlock;
+  const Philox4x32 philox(seed);
+  parallel::parallelFor(0, blocks, std::max<Index>(1, parallel::coeffWiseGrain() / perBlock), [&](Index lo, Index hi)
+  {
+    Philox4x32::Block bits[batch];
+    for (Index b0 = lo; b0 < hi; b0 += batch) {
+      const Index count = std::min(batch, hi - b0);
+      philox.generate(b0, count, bits);
+      for (Index b = 0; b < count; ++b) {
+        Scalar values[perBlock];
+        distribution(bits[b], values);
+        const Index i0 = (b0 + b) * perBlock;
+        for (Index j = 0; j < perBlock && i0 + j < size; ++j) {
+          mat[i0 + j] = values[j];
+        }
+      }
+    }
+  });
+}
+
+} // namespace rng
+} // namespace distmat
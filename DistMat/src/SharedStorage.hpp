@@ -0,0 +1,147 @@
+#pragma once
+#include "Type.hpp"
+#include "Util.hpp"
+
+#include <atomic>
+#include <utility>
+
+namespace distmat
+{
+
+/// \brief Reference counted, copy-on-write dynamic storage.
+/// Used as the `InternalStorage` of a dynamic `Matrix`, see `SharedMatrix`.
+/// Copies share the coefficients and only increase an atomic reference count,
+/// the first mutable access to a shared storage (`operator[]`, `data()`,
+/// `begin()`) copies the coefficients, so that the other owners don't see the
+/// write; constant accesses never detach. Several threads may write to the
+/// same storage, e.g. the workers of a parallel kernel: the first one detaches
+/// under a lock, the others wait for it and then write to the private copy.
+/// Copying a storage while another thread writes to it is a data race, as for
+/// any container.
+template<typename Scalar>
+class SharedStorage {
+public:
+  using value_type = Scalar;
+  using size_type = Index;
+  using iterator = Scalar*;
+  using const_iterator = const Scalar*;
+
+  /// `Matrix` shares instead of copying coefficient-wise on copy assignment.
+  static constexpr bool isCopyOnWrite = true;
+
+  SharedStorage() = default;
+
+  explicit SharedStorage(Index size) : block_(new Block{{1}, Data(size)}), unique_(true) {}
+
+  SharedStorage(const SharedStorage& other) : block_(other.acquire()) {}
+
+  SharedStorage(SharedStorage&& other) noexcept
+    : block_(other.block_.exchange(nullptr, std::memory_order_acq_rel))
+  {
+    other.unique_.store(false, std::memory_order_relaxed);
+  }
+
+  SharedStorage& operator=(const SharedStorage& other)
+  {
+    if (this != &other) {
+      unique_.store(false, std::memory_order_relaxed);
+      release(block_.exchange(other.acquire(), std::memory_order_acq_rel));
+    }
+    return *this;
+  }
+
+  SharedStorage& operator=(SharedStorage&& other) noexcept
+  {
+    if (this != &other) {
+      unique_.store(false, std::memory_order_relaxed);
+      release(block_.exchange(other.block_.exchange(nullptr, std::memory_order_acq_rel), std::memory_order_acq_rel));
+      other.unique_.store(false, std::memory_order_relaxed);
+    }
+    return *this;
+  }
+
+  ~SharedStorage() { release(block_.load(std::memory_order_acquire)); }
+
+  const Scalar& operator[](Index i) const { return block()->data[i]; }
+  Scalar&       operator[](Index i)       { return mutableBlock()->data[i]; }
+
+  const Scalar* data() const { return block() ? block()->data.data() : nullptr; }
+  Scalar*       data()       { return block() ? mutableBlock()->data.data() : nullptr; }
+  Index size() const { return block() ? block()->data.size() : 0; }
+
+  /// Whether another storage shares the coefficients.
+  bool isShared() const
+  {
+    const Block* b = block();
+    return b && b->refs.load(std::memory_order_acquire) > 1;
+  }
+
+  const_iterator begin() const { return data(); }
+  const_iterator end()   const { return data() + size(); }
+  iterator       begin()       { return data(); }
+  iterator       end()         { return data() + size(); }
+
+private:
+  using Data = vector<Scalar, util::default_init_allocator<Scalar>>;
+
+  struct Block {
+    std::atomic<Index> refs;
+    Data data;
+  };
+
+  const Block* block() const { return block_.load(std::memory_order_acquire); }
+
+  /// A new reference for a copy, so this storage is shared again.
+  Block* acquire() const
+  {
+    unique_.store(false, std::memory_order_relaxed);
+    Block* b = block_.load(std::memory_order_acquire);
+    if (b) {
+      b->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    return b;
+  }
+
+  static void release(Block* b)
+  {
+    if (b && b->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete b;
+    }
+  }
+
+  /// The fast path only reads `unique_`, which belongs to this storage, so it
+  /// never reads a block that a concurrent `detach` of this storage released.
+  Block* mutableBlock()
+  {
+    if (unique_.load(std::memory_order_acquire)) {
+      return block_.load(std::memory_order_relaxed);
+    }
+    return detach();
+  }
+
+  /// Replace a shared block by a private copy, only one thread copies. The
+  /// block can only change under the lock, so `b` stays referenced here.
+  Block* detach()
+  {
+    while (lock_.test_and_set(std::memory_order_acquire)) {}
+    Block* b = block_.load(std::memory_order_acquire);
+    if (b != nullptr && !unique_.load(std::memory_order_relaxed)) {
+      if (b->refs.load(std::memory_order_acquire) != 1) {
+        auto* copy = new Block{{1}, b->data};
+        block_.store(copy, std::memory_order_relaxed);
+        release(b);
+        b = copy;
+      }
+      unique_.store(true, std::memory_order_release);
+    }
+    lock_.clear(std::memory_order_release);
+    return b;
+  }
+
+  std::atomic<Block*> block_ = nullptr;
+  /// Whether `block_` is known not to be shared, set by `detach`.
+  mutable std::atomic<bool> unique_ = false;
+  std::atomic_flag lock_;
+};
+
+} // namespace distmat
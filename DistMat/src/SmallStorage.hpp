@@ -0,0 +1,117 @@
+#pragma once
+#include "Type.hpp"
+
+#include <memory>
+#include <cstddef>
+#include <utility>
+
+namespace distmat
+{
+
+/// \brief Dynamic storage that keeps up to `InlineSize` coefficients inline.
+/// Used as the `InternalStorage` of a dynamic `Matrix`, see `SmallMatrix`.
+/// Shapes are still determined at run time, but small matrices don't pay for
+/// a heap allocation, larger ones spill to the heap. Like
+/// `util::default_init_allocator`, the coefficients are default initialized.
+template<typename Scalar, Index InlineSize>
+class SmallStorage {
+  static_assert(InlineSize > 0, "use the default storage for matrices without inline coefficients");
+public:
+  using value_type = Scalar;
+  using size_type = Index;
+  using iterator = Scalar*;
+  using const_iterator = const Scalar*;
+
+  /// Coefficients kept inline.
+  static constexpr Index inlineSize = InlineSize;
+
+  SmallStorage() = default;
+
+  explicit SmallStorage(Index size) : data_(allocate(size)), size_(size)
+  {
+    std::uninitialized_default_construct_n(data_, size_);
+  }
+
+  SmallStorage(const SmallStorage& other) : data_(allocate(other.size_)), size_(other.size_)
+  {
+    std::uninitialized_copy_n(other.data_, size_, data_);
+  }
+
+  SmallStorage(SmallStorage&& other) noexcept(std::is_nothrow_move_constructible_v<Scalar>)
+  {
+    steal(std::move(other));
+  }
+
+  SmallStorage& operator=(const SmallStorage& other)
+  {
+    if (this != &other) {
+      SmallStorage tmp(other);
+      release();
+      steal(std::move(tmp));
+    }
+    return *this;
+  }
+
+  SmallStorage& operator=(SmallStorage&& other) noexcept(std::is_nothrow_move_constructible_v<Scalar>)
+  {
+    if (this != &other) {
+      release();
+      steal(std::move(other));
+    }
+    return *this;
+  }
+
+  ~SmallStorage() { release(); }
+
+  Scalar&       operator[](Index i)       { return data_[i]; }
+  const Scalar& operator[](Index i) const { return data_[i]; }
+
+  Scalar*       data()       { return data_; }
+  const Scalar* data() const { return data_; }
+  Index size() const { return size_; }
+  bool isInline() const { return data_ == inlineData(); }
+
+  iterator       begin()       { return data_; }
+  iterator       end()         { return data_ + size_; }
+  const_iterator begin() const { return data_; }
+  const_iterator end()   const { return data_ + size_; }
+
+private:
+  Scalar*       inlineData()       { return std::launder(reinterpret_cast<Scalar*>(buffer_)); }
+  const Scalar* inlineData() const { return std::launder(reinterpret_cast<const Scalar*>(buffer_)); }
+
+  Scalar* allocate(Index size)
+  {
+    return size <= InlineSize ? inlineData() : std::allocator<Scalar>().allocate(size);
+  }
+
+  void release()
+  {
+    std::destroy_n(data_, size_);
+    if (!isInline()) {
+      std::allocator<Scalar>().deallocate(data_, size_);
+    }
+    data_ = inlineData();
+    size_ = 0;
+  }
+
+  /// Take the coefficients of `other` and leave it empty, `*this` must be empty.
+  void steal(SmallStorage&& other)
+  {
+    if (other.isInline()) {
+      data_ = inlineData();
+      std::uninitialized_move_n(other.data_, other.size_, data_);
+      size_ = other.size_;
+      other.release();
+    } else {
+      data_ = std::exchange(other.data_, other.inlineData());
+      size_ = std::exchange(other.size_, 0);
+    }
+  }
+
+  alignas(Scalar) std::byte buffer_[InlineSize * sizeof(Scalar)];
+  Scalar* data_ = inlineData();
+  Index size_ = 0;
+};
+
+} // namespace distmat
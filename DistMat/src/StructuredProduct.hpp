@@ -0,0 +1,121 @@
+#pragma once
+#include "MatrixBase.hpp"
+#include "Multiplication.hpp"
+#include "Parallel.hpp"
+#include "Tuning.hpp"
+#include "Error.hpp"
+
+namespace distmat
+{
+
+namespace detail {
+  /// Copy the lower triangle of the square `C` to its upper triangle.
+  void mirrorLower(auto& C)
+  {
+    const Index n = C.rows();
+    parallel::parallelFor(0, n, parallel::grainFor(n), [&C, n](Index lo, Index hi)
+    {
+      for (Index i = lo; i < hi; ++i) {
+        for (Index j = i + 1; j < n; ++j) {
+          C(i, j) = C(j, i);
+        }
+      }
+    });
+  }
+} // namespace detail
+
+/// \brief `A * A^T`, the symmetric rank-k update (SYRK).
+/// Only the lower triangle is computed, which is half the work of a general
+/// product, and then mirrored. Rows are split among the threads by
+/// `parallel::parallelForTriangular`. `A * A.transpose()` calls it.
+DISTMAT_TFUNC
+typename traits::mul_result<_Derived, typename traits::transpose_result<_Derived>::type>::type
+multiplyTransposed(const MatrixBase<_Derived, _Scalar>& A)
+{
+  using Result = typename traits::mul_result<_Derived, typename traits::transpose_result<_Derived>::type>::type;
+  const auto& a = A.derived();
+  const Index n = a.rows();
+  const Index kb = std::min(tuning::params().gemmBlockInner, a.cols());
+  auto C = detail::makeMatrix<Result>(n, n);
+  parallel::parallelForTriangular(n, a.cols(), [&](Index lo, Index hi)
+  {
+    vector<_Scalar> pack(kb * hi);
+    mul::multiplyTransposedLowerRows<Index>(a, C, lo, hi, kb, pack);
+  });
+  detail::mirrorLower(C);
+  return C;
+}
+
+/// \brief `A^T * A`, the Gram matrix of the columns of `A`.
+/// \see multiplyTransposed, `A.transpose() * A` calls it.
+DISTMAT_TFUNC
+typename traits::mul_result<typename traits::transpose_result<_Derived>::type, _Derived>::type
+transposedMultiply(const MatrixBase<_Derived, _Scalar>& A)
+{
+  using Result = typename traits::mul_result<typename traits::transpose_result<_Derived>::type, _Derived>::type;
+  const auto& a = A.derived();
+  const Index m = a.cols();
+  const auto& tune = tuning::params();
+  auto C = detail::makeMatrix<Result>(m, m);
+  parallel::parallelForTriangular(m, a.rows(), [&](Index lo, Index hi)
+  {
+    mul::multiplyTransposedLeftLowerRows<Index>(a, C, lo, hi, tune.gemmBlockRows, tune.gemmBlockCols);
+  });
+  detail::mirrorLower(C);
+  return C;
+}
+
+/// \brief `T * B` for a triangular `T` (TRMM).
+/// Only the `uplo` triangle of `T` is read, and its diagonal is assumed to be
+/// one for `Diag::Unit`. The zero half of `T` is skipped, so it takes half the
+/// work of `T * B`.
+template<UpLo uplo, Diag diag = Diag::NonUnit, typename _LDerived, typename _RDerived, typename _Scalar>
+  requires derived_from<_LDerived, MatrixBase<_LDerived, _Scalar>> &&
+    derived_from<_RDerived, MatrixBase<_RDerived, _Scalar>>
+typename traits::mul_result<_LDerived, _RDerived>::type
+triangularMultiply(const MatrixBase<_LDerived, _Scalar>& T, const MatrixBase<_RDerived, _Scalar>& B)
+{
+  using Result = typename traits::mul_result<_LDerived, _RDerived>::type;
+  const auto& t = T.derived();
+  const auto& b = B.derived();
+  CHECK_SQUARE(t);
+  CHECK_MUL_DIM(t, b);
+  const Index n = t.rows();
+  const auto& tune = tuning::params();
+  auto C = detail::makeMatrix<Result>(n, b.cols());
+  constexpr bool lower = uplo == UpLo::Lower;
+  constexpr bool unitDiag = diag == Diag::Unit;
+  parallel::parallelForTriangular(n, b.cols(), [&](Index lo, Index hi)
+  {
+    // row i of an upper triangle costs as much as row n - 1 - i of a lower one
+    mul::multiplyTriangularRows<Index, lower, unitDiag>(t, b, C, lower ? lo : n - hi, lower ? hi : n - lo,
+      tune.gemmBlockRows, tune.gemmBlockInner, tune.gemmBlockCols);
+  });
+  return C;
+}
+
+/// \brief `S * B` for a symmetric `S` (SYMM) of which only the `uplo` triangle
+/// is read, e.g. the lower triangle written by a Cholesky decomposition.
+template<UpLo uplo, typename _LDerived, typename _RDerived, typename _Scalar>
+  requires derived_from<_LDerived, MatrixBase<_LDerived, _Scalar>> &&
+    derived_from<_RDerived, MatrixBase<_RDerived, _Scalar>>
+typename traits::mul_result<_LDerived, _RDerived>::type
+symmetricMultiply(const MatrixBase<_LDerived, _Scalar>& S, const MatrixBase<_RDerived, _Scalar>& B)
+{
+  using Result = typename traits::mul_result<_LDerived, _RDerived>::type;
+  const auto& s = S.derived();
+  const auto& b = B.derived();
+  CHECK_SQUARE(s);
+  CHECK_MUL_DIM(s, b);
+  const Index n = s.rows();
+  const auto& tune = tuning::params();
+  auto C = detail::makeMatrix<Result>(n, b.cols());
+  parallel::parallelFor(0, n, parallel::grainFor(n * b.cols()), [&](Index lo, Index hi)
+  {
+    mul::multiplySymmetricRows<Index, uplo == UpLo::Lower>(s, b, C, lo, hi,
+      tune.gemmBlockRows, tune.gemmBlockInner, tune.gemmBlockCols);
+  });
+  return C;
+}
+
+} // namespace distmat
@@ -0,0 +1,136 @@
+#pragma once
+#include "Type.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace distmat
+{
+namespace topology
+{
+
+/// NUMA nodes and the CPUs this process may run on, read once from sysfs.
+/// Falls back to one node holding every CPU on other platforms or when sysfs
+/// is not readable (e.g. in some containers).
+struct Topology {
+  vector<vector<unsigned>> nodeCpus;
+  /// CPUs ordered node by node, consecutive workers thus share a node.
+  vector<unsigned> cpus;
+
+  Index numNodes() const { return nodeCpus.size(); }
+};
+
+namespace detail {
+  /// Parse a sysfs cpulist like "0-3,8,10-11".
+  inline vector<unsigned> parseCpuList(const string& list)
+  {
+    vector<unsigned> cpus;
+    std::stringstream ss(list);
+    string range;
+    while (std::getline(ss, range, ',')) {
+      if (range.empty() || range == "\n") {
+        continue;
+      }
+      const auto dash = range.find('-');
+      const unsigned first = std::stoul(range.substr(0, dash));
+      const unsigned last = dash == string::npos ? first : std::stoul(range.substr(dash + 1));
+      for (unsigned cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    }
+    return cpus;
+  }
+
+  inline bool isAllowed([[maybe_unused]] unsigned cpu)
+  {
+#ifdef __linux__
+    static const cpu_set_t allowed = [] {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        for (unsigned i = 0; i < CPU_SETSIZE; ++i) {
+          CPU_SET(i, &set);
+        }
+      }
+      return set;
+    }();
+    return cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed);
+#else
+    return true;
+#endif
+  }
+
+  inline Topology detect()
+  {
+    Topology topo;
+    for (unsigned node = 0; ; ++node) {
+      std::ifstream file("/sys/devices/system/node/node" + to_string(node) + "/cpulist");
+      if (!file) {
+        break;
+      }
+      string list;
+      std::getline(file, list);
+      vector<unsigned> cpus;
+      for (auto cpu : parseCpuList(list)) {
+        if (isAllowed(cpu)) {
+          cpus.push_back(cpu);
+        }
+      }
+      if (!cpus.empty()) {
+        topo.nodeCpus.push_back(std::move(cpus));
+      }
+    }
+    if (topo.nodeCpus.empty()) {
+      vector<unsigned> cpus;
+      for (unsigned cpu = 0; cpu < std::max(1U, std::thread::hardware_concurrency()); ++cpu) {
+        if (isAllowed(cpu)) {
+          cpus.push_back(cpu);
+        }
+      }
+      topo.nodeCpus.push_back(cpus.empty() ? vector<unsigned>{0} : cpus);
+    }
+    for (const auto& cpus : topo.nodeCpus) {
+      topo.cpus.insert(topo.cpus.end(), cpus.begin(), cpus.end());
+    }
+    return topo;
+  }
+} // namespace detail
+
+inline const Topology& get()
+{
+  static const Topology topo = detail::detect();
+  return topo;
+}
+
+/// Restrict the calling thread to `cpus`, returns false if it is not supported.
+inline bool pinCurrentThread([[maybe_unused]] const vector<unsigned>& cpus)
+{
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto cpu : cpus) {
+    CPU_SET(cpu, &set);
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+/// CPU of worker `t` out of `n`, workers are spread evenly over `get().cpus`
+/// so that contiguous chunks of work stay on the same node.
+inline unsigned workerCpu(Index t, Index n)
+{
+  const auto& cpus = get().cpus;
+  return cpus[t * cpus.size() / std::max<Index>(n, 1) % cpus.size()];
+}
+
+} // namespace topology
+} // namespace distmat
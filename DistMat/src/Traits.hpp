@@ -1,6 +1,7 @@
 #pragma once
 #include "Util.hpp"
 #include <concepts>
+#include <type_traits>
 /// Type traits for matrix and scalar.
 
 namespace distmat {
@@ -18,5 +19,28 @@ template<typename Scalar>
     static constexpr std::remove_cvref_t<Scalar> one = 1;
   };
 
+/// Type of `lhs * rhs`, the type of `lhs` unless specialized.
+template<typename LDerived, typename RDerived>
+  struct mul_result { using type = LDerived; };
+
+/// Type of the evaluated `mat.transpose()`, the type of `mat` unless specialized.
+template<typename Derived>
+  struct transpose_result { using type = Derived; };
+
+/// Storage of a matrix that owns its coefficients, the storage itself unless
+/// it refers to coefficients owned elsewhere.
+template<typename Storage>
+  struct plain_storage { using type = Storage; };
+
+/// Matrix an expression such as `mat.transpose()` evaluates to, the type itself
+/// for matrices. Results of the operators have this type.
+template<typename Derived>
+  struct eval_result { using type = Derived; };
+
+/// Whether the coefficients of an expression can't be written, e.g. of a
+/// `TransposeView`. The mutable accessors of `MatrixBase` are disabled then.
+template<typename Derived>
+  struct is_read_only : std::false_type {};
+
 } // namespace traits
 } // namespace distmat
\ No newline at end of file
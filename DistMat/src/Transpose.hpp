@@ -0,0 +1,160 @@
+#pragma once
+#include "MatrixBase.hpp"
+#include "StructuredProduct.hpp"
+#include "Parallel.hpp"
+#include "Tuning.hpp"
+#include "Error.hpp"
+
+namespace distmat
+{
+
+/// \brief Read-only transposed view of a matrix, returned by `transpose()`.
+/// `t(i, j)` is `mat(j, i)` and the view refers to `mat`, so it must not
+/// outlive it: `auto t = A.transpose();` is fine as long as `A` lives, while
+/// the transpose of a temporary is a matrix instead of a view. The view has no
+/// mutable accessors, see `traits::is_read_only`. It is evaluated when it is
+/// assigned or converted to a matrix, or by `eval()`. `A * A.transpose()` and `A.transpose() * A` are computed by
+/// `multiplyTransposed` and `transposedMultiply`, other products evaluate the
+/// view first.
+template<typename MatrixType>
+class TransposeView : public MatrixBase<TransposeView<MatrixType>, typename MatrixType::scalar_type> {
+public:
+  using scalar_type = typename MatrixType::scalar_type;
+  using Base = MatrixBase<TransposeView, scalar_type>;
+  using PlainType = typename traits::transpose_result<MatrixType>::type;
+
+  constexpr explicit TransposeView(const MatrixType& mat) : mat_(mat) {}
+
+  constexpr const scalar_type& operator()(Index row, Index col) const { return mat_(col, row); }
+  constexpr const scalar_type& at(Index row, Index col) const { return mat_.at(col, row); }
+  /// Coefficient `i` of the transpose spanned with row major.
+  constexpr const scalar_type& operator[](Index i) const { return mat_(i % mat_.rows(), i / mat_.rows()); }
+
+  constexpr Index rows() const { return mat_.cols(); }
+  constexpr Index cols() const { return mat_.rows(); }
+
+  /// The transposed matrix.
+  constexpr const MatrixType& nestedExpression() const { return mat_; }
+  /// Transposing again gives the matrix back without a copy.
+  constexpr const MatrixType& transpose() const { return mat_; }
+
+  PlainType eval() const
+  {
+    auto ret = detail::makeMatrix<PlainType>(rows(), cols());
+    evalTo(ret);
+    return ret;
+  }
+  operator PlainType() const { return eval(); }
+
+#define DEFINE_FUNC_EVAL_ADD_SUB_TO(func, op) \
+  template<typename OtherDerived>\
+    requires derived_from<OtherDerived, MatrixBase<OtherDerived, scalar_type>>\
+  void func(OtherDerived& other) const\
+  {\
+    apply(other, [](scalar_type& dst, const scalar_type& src) { dst op src; });\
+  }
+  DEFINE_FUNC_EVAL_ADD_SUB_TO(evalTo, =)
+  DEFINE_FUNC_EVAL_ADD_SUB_TO(addTo, +=)
+  DEFINE_FUNC_EVAL_ADD_SUB_TO(subTo, -=)
+#undef DEFINE_FUNC_EVAL_ADD_SUB_TO
+
+private:
+  /// `f(dst(i, j), mat(j, i))` for all coefficients, in square tiles so that
+  /// neither matrix is walked with a stride of a whole row. Row tiles of `mat`
+  /// are split among the threads. `A = A.transpose()` and `A += A.transpose()`
+  /// evaluate the transpose first.
+  template<typename OtherDerived, typename F>
+  void apply(OtherDerived& dst, F f) const
+  {
+    CHECK_DIM(dst, (*this));
+    if (static_cast<const void*>(&dst) == static_cast<const void*>(&mat_)) {
+      const PlainType tmp = eval();
+      for (Index i = 0; i < tmp.size(); ++i) {
+        f(dst[i], tmp[i]);
+      }
+      return;
+    }
+    const Index rows = mat_.rows();
+    const Index cols = mat_.cols();
+    const Index tile = tuning::params().transposeBlock;
+    parallel::parallelFor(0, (rows + tile - 1) / tile, parallel::grainFor(tile * cols), [&](Index lo, Index hi)
+    {
+      for (Index row0 = lo * tile; row0 < std::min(hi * tile, rows); row0 += tile) {
+        for (Index col0 = 0; col0 < cols; col0 += tile) {
+          for (Index row = row0; row < std::min(row0 + tile, rows); ++row) {
+            for (Index col = col0; col < std::min(col0 + tile, cols); ++col) {
+              f(dst(col, row), mat_(row, col));
+            }
+          }
+        }
+      }
+    });
+  }
+
+  const MatrixType& mat_;
+};
+
+namespace traits {
+
+  template<typename MatrixType>
+    struct is_read_only<TransposeView<MatrixType>> : std::true_type {};
+
+  template<typename MatrixType>
+    struct eval_result<TransposeView<MatrixType>> {
+      using type = typename transpose_result<MatrixType>::type;
+    };
+
+  template<typename LDerived, typename RDerived>
+    struct mul_result<TransposeView<LDerived>, RDerived> {
+      using type = typename mul_result<typename eval_result<TransposeView<LDerived>>::type, RDerived>::type;
+    };
+
+  template<typename LDerived, typename RDerived>
+    struct mul_result<LDerived, TransposeView<RDerived>> {
+      using type = typename mul_result<LDerived, typename eval_result<TransposeView<RDerived>>::type>::type;
+    };
+
+  template<typename LDerived, typename RDerived>
+    struct mul_result<TransposeView<LDerived>, TransposeView<RDerived>> {
+      using type = typename mul_result<typename eval_result<TransposeView<LDerived>>::type,
+        typename eval_result<TransposeView<RDerived>>::type>::type;
+    };
+
+} // namespace traits
+
+/// `A * A.transpose()` is the symmetric `multiplyTransposed(A)`.
+template<typename _LDerived, typename _RDerived>
+  requires IsMatrixExpression<_LDerived>
+typename traits::mul_result<_LDerived, TransposeView<_RDerived>>::type
+operator*(const _LDerived& lhs, const TransposeView<_RDerived>& rhs)
+{
+  if constexpr (same_as<_LDerived, _RDerived>) {
+    if (&lhs == &rhs.nestedExpression()) {
+      return multiplyTransposed(lhs);
+    }
+  }
+  return lhs * rhs.eval();
+}
+
+/// `A.transpose() * A` is the symmetric `transposedMultiply(A)`.
+template<typename _LDerived, typename _RDerived>
+  requires IsMatrixExpression<_RDerived>
+typename traits::mul_result<TransposeView<_LDerived>, _RDerived>::type
+operator*(const TransposeView<_LDerived>& lhs, const _RDerived& rhs)
+{
+  if constexpr (same_as<_LDerived, _RDerived>) {
+    if (&lhs.nestedExpression() == &rhs) {
+      return transposedMultiply(rhs);
+    }
+  }
+  return lhs.eval() * rhs;
+}
+
+template<typename _LDerived, typename _RDerived>
+typename traits::mul_result<TransposeView<_LDerived>, TransposeView<_RDerived>>::type
+operator*(const TransposeView<_LDerived>& lhs, const TransposeView<_RDerived>& rhs)
+{
+  return lhs.eval() * rhs.eval();
+}
+
+} // namespace distmat
@@ -0,0 +1,162 @@
+#pragma once
+#include "Type.hpp"
+
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+namespace distmat
+{
+namespace tuning
+{
+
+/// Block sizes, grains and crossovers of the kernels. The defaults are
+/// reasonable for a current x86 core, `autotune()` in Autotune.hpp measures
+/// better ones for the host CPU and saves them to `profilePath()`, where they
+/// are loaded from by every later run.
+struct Params {
+  Index gemmBlockRows = 64;       ///< rows of A and C in a tile of the blocked multiplication
+  Index gemmBlockInner = 128;     ///< columns of A and rows of B in a tile
+  Index gemmBlockCols = 256;      ///< columns of B and C in a tile
+  Index gemmBlockedMinSize = 48;  ///< `operator*` uses the blocked kernel once m, n and k reach this
+  Index transposeBlock = 32;      ///< square tile of `transpose()`
+  Index decompBlockSize = 64;     ///< panel width of the decompositions and TRSM
+  Index parallelMinWork = Index(1) << 15;  ///< minimal work of a `parallelFor` task, see `parallel::grainFor`
+  Index coeffWiseGrain = Index(1) << 14;   ///< coefficients per task of the coefficient-wise kernels
+  Index gevmBlockCols = 4096;     ///< columns of the tile of y of the vector-matrix product
+  Index blasMinWork = Index(1) << 15;  ///< multiply-adds (or coefficients) from which CBLAS is called, see Backend.hpp
+};
+
+/// Names of the fields in a profile file.
+inline constexpr std::array<std::pair<const char*, Index Params::*>, 10> fields = {{
+  {"gemmBlockRows", &Params::gemmBlockRows},
+  {"gemmBlockInner", &Params::gemmBlockInner},
+  {"gemmBlockCols", &Params::gemmBlockCols},
+  {"gemmBlockedMinSize", &Params::gemmBlockedMinSize},
+  {"transposeBlock", &Params::transposeBlock},
+  {"decompBlockSize", &Params::decompBlockSize},
+  {"parallelMinWork", &Params::parallelMinWork},
+  {"coeffWiseGrain", &Params::coeffWiseGrain},
+  {"gevmBlockCols", &Params::gevmBlockCols},
+  {"blasMinWork", &Params::blasMinWork},
+}};
+
+/// CPU model from /proc/cpuinfo, "unknown" if it is not available.
+inline string cpuModel()
+{
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  string line;
+  while (std::getline(cpuinfo, line)) {
+    if (line.rfind("model name", 0) == 0) {
+      const auto colon = line.find(':');
+      if (colon != string::npos && colon + 2 <= line.size()) {
+        return line.substr(colon + 2);
+      }
+    }
+  }
+  return "unknown";
+}
+
+/// Profile of this machine: `$DISTMAT_TUNING_PROFILE` if set, otherwise
+/// `$XDG_CACHE_HOME/distmat/<cpu model>.profile` (`$HOME/.cache` by default).
+/// Empty if none of the variables is set or `$DISTMAT_TUNING_PROFILE` is
+/// empty, then the defaults are used.
+inline std::filesystem::path profilePath()
+{
+  if (const char* path = std::getenv("DISTMAT_TUNING_PROFILE")) {
+    return path;
+  }
+  std::filesystem::path dir;
+  if (const char* cache = std::getenv("XDG_CACHE_HOME")) {
+    dir = cache;
+  } else if (const char* home = std::getenv("HOME")) {
+    dir = std::filesystem::path(home) / ".cache";
+  } else {
+    return {};
+  }
+  string name = cpuModel();
+  for (auto& c : name) {
+    if (!std::isalnum(static_cast<unsigned char>(c))) {
+      c = '_';
+    }
+  }
+  return dir / "distmat" / (name + ".profile");
+}
+
+/// Write `params` to `path`, returns false on failure.
+inline bool save(const Params& params, const std::filesystem::path& path)
+{
+  std::error_code ec;
+  if (path.has_parent_path()) {
+    std::filesystem::create_directories(path.parent_path(), ec);
+  }
+  std::ofstream file(path);
+  if (!file) {
+    return false;
+  }
+  file << "# DistMat tuning profile\n";
+  file << "cpu " << cpuModel() << '\n';
+  for (const auto& [name, field] : fields) {
+    file << name << ' ' << params.*field << '\n';
+  }
+  return bool(file);
+}
+
+/// Read a profile written by `save`. Unknown keys and invalid values are
+/// ignored, so are profiles measured on another CPU model.
+inline bool load(Params& params, const std::filesystem::path& path)
+{
+  std::ifstream file(path);
+  if (!file) {
+    return false;
+  }
+  Params loaded = params;
+  string line;
+  while (std::getline(file, line)) {
+    std::istringstream ss(line);
+    string key;
+    ss >> key;
+    if (key.empty() || key[0] == '#') {
+      continue;
+    }
+    if (key == "cpu") {
+      string model;
+      std::getline(ss >> std::ws, model);
+      if (model != cpuModel()) {
+        return false;
+      }
+      continue;
+    }
+    Index value = 0;
+    if (!(ss >> value) || value == 0) {
+      continue;
+    }
+    for (const auto& [name, field] : fields) {
+      if (key == name) {
+        loaded.*field = value;
+      }
+    }
+  }
+  params = loaded;
+  return true;
+}
+
+/// Parameters used by the kernels, loaded from `profilePath()` on first use.
+inline Params& params()
+{
+  static Params params = [] {
+    Params p;
+    if (const auto path = profilePath(); !path.empty()) {
+      load(p, path);
+    }
+    return p;
+  }();
+  return params;
+}
+
+} // namespace tuning
+} // namespace distmat
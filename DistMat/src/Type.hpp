@@ -19,4 +19,9 @@ using std::initializer_list;
 
 namespace ranges = std::ranges;
 namespace views = std::views;
+
+/// Structure of the operands of the triangular and symmetric kernels.
+enum class Side { Left, Right };
+enum class UpLo { Lower, Upper };
+enum class Diag { NonUnit, Unit };
 } // namespace distmat
@@ -1,10 +1,155 @@
 #include "Bench.hpp"
 
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <sstream>
+
 namespace test
 {
+
+namespace {
+  /// Members of `Counters` in the order of `PerfCounters::fds_`.
+  constexpr std::array<std::optional<double> Counters::*, 5> counterFields = {
+    &Counters::cycles,
+    &Counters::instructions,
+    &Counters::l1dMisses,
+    &Counters::llcMisses,
+    &Counters::branchMisses,
+  };
+
+#ifdef __linux__
+  constexpr uint64_t cacheReadMiss(uint64_t cache)
+  {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  }
+
+  /// Type and config of the events in the order of `counterFields`.
+  constexpr std::array<std::pair<uint32_t, uint64_t>, 5> events = {{
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, cacheReadMiss(PERF_COUNT_HW_CACHE_L1D)},
+    {PERF_TYPE_HW_CACHE, cacheReadMiss(PERF_COUNT_HW_CACHE_LL)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+  }};
+
+  /// Open a disabled user space counter of this thread and its future threads,
+  /// -1 if it is not available.
+  int openEvent(uint32_t type, uint64_t config)
+  {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+#endif
+} // namespace
+
+std::optional<double> Counters::ipc() const
+{
+  if (!cycles || !instructions || *cycles == 0) {
+    return std::nullopt;
+  }
+  return *instructions / *cycles;
+}
+
+std::optional<double> Counters::perFlop(const std::optional<double>& misses, double flops)
+{
+  if (!misses || flops <= 0) {
+    return std::nullopt;
+  }
+  return *misses / flops;
+}
+
+PerfCounters::PerfCounters(bool enabled)
+{
+  fds_.fill(-1);
+#ifdef __linux__
+  if (enabled) {
+    for (size_t i = 0; i < fds_.size(); ++i) {
+      fds_[i] = openEvent(events[i].first, events[i].second);
+    }
+  }
+#else
+  (void)enabled;
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+  for (int fd : fds_) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+#endif
+}
+
+void PerfCounters::start()
+{
+#ifdef __linux__
+  for (int fd : fds_) {
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+#endif
+}
+
+Counters PerfCounters::stop()
+{
+  Counters counters;
+#ifdef __linux__
+  for (int fd : fds_) {
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+  for (size_t i = 0; i < fds_.size(); ++i) {
+    // value, time enabled, time running
+    uint64_t values[3] = {};
+    if (fds_[i] < 0 || read(fds_[i], values, sizeof(values)) != ssize_t(sizeof(values)) || values[2] == 0) {
+      continue;
+    }
+    // scale up if the counter was multiplexed with others
+    counters.*counterFields[i] = double(values[0]) * double(values[1]) / double(values[2]);
+  }
+#endif
+  return counters;
+}
+
 string serialize(const Bench& bench)
 {
-  string str(bench.name + "\t " + to_string(bench.duration.count()) + "ms");
-  return str;
+  std::ostringstream str;
+  str << bench.name << "\t " << to_string(bench.duration.count()) << "ms";
+  const auto& c = bench.counters;
+  auto field = [&str](const char* name, const std::optional<double>& value)
+  {
+    if (value) {
+      str << "\t " << name << "=" << *value;
+    }
+  };
+  field("cycles", c.cycles);
+  field("instructions", c.instructions);
+  field("ipc", c.ipc());
+  field("l1d-misses", c.l1dMisses);
+  field("llc-misses", c.llcMisses);
+  field("branch-misses", c.branchMisses);
+  field("l1d-misses/flop", Counters::perFlop(c.l1dMisses, bench.flops));
+  field("llc-misses/flop", Counters::perFlop(c.llcMisses, bench.flops));
+  return str.str();
 }
-} // namespace test
\ No newline at end of file
+} // namespace test
@@ -1,30 +1,80 @@
 #pragma once
 #include "BasicTest.hpp"
 
+#include <array>
+#include <cstdlib>
+#include <optional>
+
 namespace test
 {
 
+/// Hardware counters of a benchmark, summed over all its threads. A counter
+/// is empty if it couldn't be read, e.g. without the permission to use
+/// perf_event_open in a container, or on a CPU without such an event.
+struct Counters {
+  std::optional<double> cycles;
+  std::optional<double> instructions;
+  std::optional<double> l1dMisses;     ///< L1 data cache read misses
+  std::optional<double> llcMisses;     ///< last level cache read misses
+  std::optional<double> branchMisses;
+
+  /// Instructions per cycle.
+  std::optional<double> ipc() const;
+  /// `misses` per floating point operation of a benchmark doing `flops` of them.
+  static std::optional<double> perFlop(const std::optional<double>& misses, double flops);
+};
+
 struct Bench : Test {
   chrono::duration<double, std::milli> duration;
+  double flops = 0;   ///< floating point operations of the benchmark, 0 if not known
+  Counters counters;
 };
 
 inline vector<Bench> allBenches; // NOLINT
 
+/// Whether `BENCH` records `Counters`, set by the environment variable
+/// `DISTMAT_BENCH_COUNTERS`.
+inline bool recordCounters = std::getenv("DISTMAT_BENCH_COUNTERS") != nullptr; // NOLINT
+
+/// The counters of `Counters`, opened on construction and counting the calling
+/// thread and the threads it creates between `start()` and `stop()`. Counters
+/// that can't be opened stay empty, the others are still recorded.
+class PerfCounters {
+public:
+  explicit PerfCounters(bool enabled = recordCounters);
+  ~PerfCounters();
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  void start();
+  Counters stop();
+
+private:
+  std::array<int, 5> fds_;
+};
+
 // NOLINTNEXTLINE
-#define BENCH(name_, desc_, cnt_, codes_) \
+#define BENCH_FLOPS(name_, desc_, cnt_, flops_, codes_) \
   {\
     Bench bench;\
     bench.name = name_;\
     bench.description = desc_;\
     bench.count = cnt_;\
+    bench.flops = flops_;\
     bench.sourceCodes = #codes_;\
     allBenches.push_back(std::move(bench));\
+    PerfCounters bench_counters;\
+    bench_counters.start();\
     auto bench_start = chrono::steady_clock::now();\
     codes_\
     allBenches.back().duration = chrono::steady_clock::now() - bench_start;\
+    allBenches.back().counters = bench_counters.stop();\
     cout << serialize(allBenches.back()) << endl;\
   }
 
+// NOLINTNEXTLINE
+#define BENCH(name_, desc_, cnt_, codes_) BENCH_FLOPS(name_, desc_, cnt_, 0, codes_)
+
 string serialize(const Bench& bench);
 
-} // namespace test
\ No newline at end of file
+} // namespace test
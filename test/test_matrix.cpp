@@ -1,9 +1,19 @@
 #include <iostream>
 #include "DistMat/src/Matrix.hpp"
+#include "DistMat/src/Decomposition.hpp"
+#include "DistMat/src/Autotune.hpp"
+#include "DistMat/src/IO.hpp"
+#include "DistMat/src/EigenMap.hpp"
+#include "DistMat/src/IterativeSolver.hpp"
+#include <sstream>
+#include <limits>
 #include "Bench.hpp"
 using namespace distmat;
 using namespace test;
 
+template<typename T>
+  concept IsWritable = requires (T& t) { t(0, 0) = 1.0; t[0] = 1.0; };
+
 template<typename Mat>
 void test_add_eq_mul(Mat& A, int cnt)
 {
@@ -86,12 +96,918 @@ void test_default_init(int cnt)
   }
 }
 
+template<typename Mat>
+double maxAbsDiff(const Mat& A, const Mat& B)
+{
+  double diff = 0.0;
+  for (Index i = 0; i < A.size(); ++i) {
+    diff = std::max(diff, std::abs(double(A[i] - B[i])));
+  }
+  return diff;
+}
+
+void test_lu_solve(Index n)
+{
+  Matrix<double> A(n, n);
+  Matrix<double> B(n, 3);
+  for (Index i = 0; i < n; ++i) {
+    for (Index j = 0; j < n; ++j) {
+      // pseudo random, needs pivoting
+      uint64_t h = (i * n + j) * 6364136223846793005ULL + 1442695040888963407ULL;
+      A(i, j) = double((h ^ (h >> 33)) % 1000) - 500.0;
+    }
+    for (Index j = 0; j < B.cols(); ++j) {
+      B(i, j) = double((i + j) % 5);
+    }
+  }
+  Matrix<double> X(n, B.cols());
+  BENCH("m:lu:solve", "solve A * X = B with blocked LU with partial pivoting", 1,
+    X = solve(A, B);
+  )
+  if (maxAbsDiff(A * X, B) > 1e-8) {
+    throw make_tuple(allBenches.back(), A, B);
+  }
+}
+
+void test_llt(Index n)
+{
+  Matrix<double> A(n, n);
+  for (Index i = 0; i < n; ++i) {
+    for (Index j = 0; j < n; ++j) {
+      A(i, j) = i == j ? double(n) : 1.0 / double(1 + i + j);
+    }
+  }
+  Matrix<double> L(n, n);
+  BENCH("m:llt:factorize", "blocked Cholesky decomposition", 1,
+    L = LLT<Matrix<double>>(A, 16).matrixL();
+  )
+  if (maxAbsDiff(L * L.transpose(), A) > 1e-8) {
+    throw make_tuple(allBenches.back(), A, L);
+  }
+}
+
+void test_pow(int cnt)
+{
+  Matrix<long long> F(2, 2);
+  F = {1, 1, 1, 0};
+  Matrix<long long> P(2, 2);
+  BENCH("m:pow", "Fibonacci numbers by exponentiation by squaring", cnt,
+    for (int i = 0; i < cnt; ++i) {
+      P = matrixPower(F, 90);
+    }
+  )
+  if (P(0, 1) != 2880067194370816120LL || matrixPower(F, 0) != Matrix<long long>::eye(2, 2)) {
+    throw make_tuple(allBenches.back(), F, P);
+  }
+
+  Matrix<double> T(4, 4);
+  Matrix<double> X(4, 2);
+  for (Index i = 0; i < T.size(); ++i) {
+    T[i] = double(i % 3) / 4.0;
+  }
+  for (Index i = 0; i < X.size(); ++i) {
+    X[i] = double(i);
+  }
+  for (auto k : {0ULL, 1ULL, 2ULL, 3ULL, 40ULL}) {
+    Matrix<double> Y = X;
+    applyRepeated(T, Y, k);
+    Matrix<double> Z = X;
+    for (unsigned long long i = 0; i < k; ++i) {
+      Z = T * Z;
+    }
+    if (maxAbsDiff(Y, Z) > 1e-9 * (1.0 + std::abs(Z[0]))) {
+      throw make_tuple(allBenches.back(), Y, Z);
+    }
+  }
+
+  // k * X.cols() wraps around, a cyclic shift of order 4 is applied by squaring
+  Matrix<double> S = Matrix<double>::zeros(4, 4);
+  for (Index i = 0; i < 4; ++i) {
+    S(i, (i + 1) % 4) = 1.0;
+  }
+  Matrix<double> Y = X;
+  applyRepeated(S, Y, (1ULL << 63) + 1);
+  if (Y != S * X) {
+    throw make_tuple(allBenches.back(), Y);
+  }
+}
+
+void test_numa_policy(Index n)
+{
+  parallel::setPinThreads(true);
+  for (auto policy : {numa::Policy::Interleave, numa::Policy::RowBlock, numa::Policy::FirstTouch}) {
+    Matrix<double> A(n, n, policy);
+    Matrix<double> B(n, n, policy);
+    for (Index i = 0; i < A.size(); ++i) {
+      A[i] = double(i);
+      B[i] = 1.0;
+    }
+    BENCH("m:numa:add", "A += B on NUMA placed matrices with pinned workers", 1,
+      A += B;
+    )
+    for (Index i = 0; i < A.size(); ++i) {
+      if (A[i] != double(i) + 1.0) {
+        throw make_tuple(allBenches.back(), A, B);
+      }
+    }
+
+    // memory of the matrices freed above is recycled and already touched,
+    // `place` must migrate it
+    Matrix<double> C(n, n);
+    for (Index i = 0; i < C.size(); ++i) {
+      C[i] = 1.0;
+    }
+    Index misplaced = 0;
+    BENCH("m:numa:place", "place a touched matrix", 1,
+      misplaced = numa::place(C.data(), C.size(), C.cols(), policy);
+    )
+    if (misplaced != 0 || C[0] != 0.0 || C[C.size() - 1] != 0.0) {
+      throw make_tuple(allBenches.back(), C, misplaced);
+    }
+    const Index nodes = topology::get().numNodes();
+    if (nodes == 1 || numa::nodeOf(C.data()) < 0) {
+      continue;
+    }
+    if (policy == numa::Policy::RowBlock
+        && (numa::nodeOf(C.data()) != 0 || numa::nodeOf(C.data() + C.size() - 1) != int(nodes - 1))) {
+      throw make_tuple(allBenches.back(), C, nodes);
+    }
+    if (policy == numa::Policy::Interleave) {
+      const Index pageSize = numa::detail::pageBytes() / sizeof(double);
+      const auto address = reinterpret_cast<std::uintptr_t>(C.data());
+      const Index head = (numa::detail::pageBytes() - address % numa::detail::pageBytes()) % numa::detail::pageBytes() / sizeof(double);
+      for (Index page = 0; page < 2 * nodes && head + (page + 1) * pageSize <= C.size(); ++page) {
+        if (numa::nodeOf(C.data() + head + page * pageSize) != int(page % nodes)) {
+          throw make_tuple(allBenches.back(), C, page);
+        }
+      }
+    }
+  }
+  parallel::setPinThreads(false);
+}
+
+void test_bench_counters()
+{
+  // known readings, independent of the permission to use perf_event_open
+  Bench bench;
+  bench.name = "counters";
+  bench.flops = 1000.0;
+  bench.counters.cycles = 400.0;
+  bench.counters.instructions = 1000.0;
+  bench.counters.l1dMisses = 250.0;
+  const string line = serialize(bench);
+  for (const char* field : {"\t cycles=400", "\t instructions=1000", "\t ipc=2.5", "\t l1d-misses=250", "\t l1d-misses/flop=0.25"}) {
+    if (line.find(field) == string::npos) {
+      throw make_tuple(line, string(field));
+    }
+  }
+  // counters that couldn't be read and unknown flops are left out
+  if (line.find("llc-misses") != string::npos || line.find("branch-misses") != string::npos) {
+    throw make_tuple(line, string("llc-misses"));
+  }
+  bench.flops = 0;
+  bench.counters.cycles = 0.0;
+  if (bench.counters.ipc() || Counters::perFlop(bench.counters.l1dMisses, bench.flops) || Counters{}.ipc()) {
+    throw make_tuple(serialize(bench), string("ipc"));
+  }
+
+  // disabled counters record nothing
+  PerfCounters disabled(false);
+  disabled.start();
+  const auto counters = disabled.stop();
+  if (counters.cycles || counters.instructions || counters.l1dMisses || counters.llcMisses || counters.branchMisses) {
+    throw make_tuple(serialize(bench), string("disabled"));
+  }
+}
+
+void test_autotune()
+{
+  const auto defaults = tuning::params();
+  tuning::AutotuneOptions options;
+  options.gemmSize = 64;
+  options.crossoverMaxSize = 32;
+  options.transposeSize = 64;
+  options.decompSize = 64;
+  options.coeffWiseSize = 4096;
+  options.gevmSize = 64;
+  options.repeats = 1;
+  options.save = false;
+  tuning::Params tuned;
+  BENCH("m:autotune", "autotune the kernel parameters with small problems", 1,
+    tuned = tuning::autotune(options);
+  )
+
+  const auto path = std::filesystem::temp_directory_path() / "distmat_test.profile";
+  tuning::Params loaded;
+  if (!tuning::save(tuned, path) || !tuning::load(loaded, path)) {
+    throw allBenches.back();
+  }
+  std::filesystem::remove(path);
+  if (tuned.gemmBlockedMinSize > options.crossoverMaxSize + 1) {
+    throw make_tuple(allBenches.back(), tuned.gemmBlockedMinSize);
+  }
+  for (const auto& [name, field] : tuning::fields) {
+    if (loaded.*field != tuned.*field) {
+      throw make_tuple(allBenches.back(), string(name));
+    }
+  }
+
+  Matrix<double> A(70, 50);
+  Matrix<double> B(50, 90);
+  for (Index i = 0; i < A.size(); ++i) {
+    A[i] = double(i % 11);
+  }
+  for (Index i = 0; i < B.size(); ++i) {
+    B[i] = double(i % 7);
+  }
+  Matrix<double> C = Matrix<double>::zeros(70, 90);
+  mul::multiplyMatrix<Index>(A, B, C);
+  tuning::params().gemmBlockedMinSize = 1;
+  if (A * B != C || A.transpose().eval().transpose() != A) {
+    throw make_tuple(allBenches.back(), A, B);
+  }
+
+  // no tried order is large enough for the blocked multiplication to win
+  options.crossoverMaxSize = 4;
+  if (tuning::autotune(options).gemmBlockedMinSize != 5) {
+    throw make_tuple(allBenches.back(), tuning::params().gemmBlockedMinSize);
+  }
+  tuning::params() = defaults;
+}
+
+void test_partially_fixed(Index n, int cnt)
+{
+  Matrix<double, -1, 3> A(n, 3);
+  Matrix<double> D(n, 3);
+  for (Index i = 0; i < A.size(); ++i) {
+    A[i] = double(i % 13);
+    D[i] = A[i];
+  }
+  Matrix<double, 3, 3> R = Matrix<double, 3, 3>::eye();
+  R(0, 1) = 2.0;
+  R(2, 0) = -1.0;
+  Matrix<double> DR(3, 3);
+  for (Index i = 0; i < R.size(); ++i) {
+    DR[i] = R[i];
+  }
+
+  static_assert(is_same_v<decltype(A * R), Matrix<double, -1, 3>>);
+  static_assert(is_same_v<decltype(A.transpose().eval()), Matrix<double, 3, -1>>);
+  static_assert(is_same_v<decltype(A.transpose() * A), Matrix<double, 3, 3>>);
+
+  Matrix<double, -1, 3> B(n, 3);
+  BENCH("m:partially_fixed:mul", "tall-skinny Matrix<double, -1, 3> times Matrix<double, 3, 3>", cnt,
+    for (int i = 0; i < cnt; ++i) {
+      B = A * R;
+    }
+  )
+  const auto DB = D * DR;
+  for (Index i = 0; i < B.size(); ++i) {
+    if (B[i] != DB[i]) {
+      throw make_tuple(allBenches.back(), D, DB);
+    }
+  }
+  const auto G = A.transpose() * A;
+  const auto DG = D.transpose() * D;
+  for (Index i = 0; i < G.size(); ++i) {
+    if (G[i] != DG[i]) {
+      throw make_tuple(allBenches.back(), D, DG);
+    }
+  }
+
+  bool isThrown = false;
+  try {
+    Matrix<double, -1, 3> C(n, 4);
+  } catch (const std::runtime_error&) {
+    isThrown = true;
+  }
+  if (!isThrown) {
+    throw allBenches.back();
+  }
+}
+
+void test_small_storage(int cnt)
+{
+  using Small = SmallMatrix<double, 36>;
+  BENCH("m:small_storage:constructor", "construct runtime-sized 6x6 matrices with inline storage", cnt,
+    for (int i = 0; i < cnt; ++i) {
+      Small A(6, 6);
+      A[0] = double(i);
+    }
+  )
+  BENCH("m:small_storage:heap_constructor", "construct runtime-sized 6x6 matrices with heap storage", cnt,
+    for (int i = 0; i < cnt; ++i) {
+      Matrix<double> A(6, 6);
+      A[0] = double(i);
+    }
+  )
+
+  // inline and spilled matrices, copied, moved and multiplied
+  for (Index n : {3, 6, 7}) {
+    auto A = Small::eye(n, n);
+    A(0, n - 1) = 2.0;
+    Small B = A;
+    Small C = std::move(B);
+    static_assert(is_same_v<decltype(A * C), Small>);
+    const auto D = A * C;
+    if (D(0, n - 1) != 4.0 || D(1, 1) != 1.0 || C != A || D.transpose()(n - 1, 0) != 4.0) {
+      throw make_tuple(allBenches.back(), D);
+    }
+  }
+}
+
+void test_text_io(Index n)
+{
+  Matrix<double> A(n, 7);
+  for (Index i = 0; i < A.size(); ++i) {
+    A[i] = (double(i) - 3.0) / 7.0;
+  }
+  std::stringstream ss;
+  BENCH("m:io:write", "write a matrix as text with to_chars", 1,
+    io::writeText(ss, A, {','});
+  )
+  Matrix<double> B;
+  BENCH("m:io:read", "parse a text matrix with from_chars", 1,
+    B = io::readText(ss);
+  )
+  if (B.rows() != A.rows() || B.cols() != A.cols() || B != A) {
+    throw make_tuple(allBenches.back(), A, B);
+  }
+
+  // the matrix is read from where the caller stopped, e.g. after a header
+  std::stringstream hs("3 2\n1 2\n3 4\n5 6\n");
+  Index headerRows = 0;
+  Index headerCols = 0;
+  hs >> headerRows >> headerCols;
+  const auto H = io::readText<Matrix<int>>(hs);
+  if (H.rows() != headerRows || H.cols() != headerCols || H(0, 0) != 1 || H(2, 1) != 6) {
+    throw make_tuple(allBenches.back(), H);
+  }
+
+  const auto C = io::parseText<Matrix<int, -1, 3>>("1, 2,3\r\n\n  4\t5 +6\n7;8;9");
+  if (C.rows() != 3 || C(1, 2) != 6 || C(2, 0) != 7) {
+    throw make_tuple(allBenches.back(), C);
+  }
+  for (const char* text : {"1 2 3\n4 5\n", "1,,2\n3,4,5\n", "1,2,3\n4,,5,6\n", ",1,2\n", "1;2;\n", "1 2\n,\n"}) {
+    bool isThrown = false;
+    try {
+      io::parseText(text);
+    } catch (const std::runtime_error&) {
+      isThrown = true;
+    }
+    if (!isThrown) {
+      throw make_tuple(allBenches.back(), string(text));
+    }
+  }
+
+  // the longest coefficients still fit the formatting buffer
+  Matrix<long double> L(2, 2);
+  L = {-std::numeric_limits<long double>::max(), -std::numeric_limits<long double>::min(),
+       std::nextafter(-1.0L, 0.0L), -1.0L / 3.0L};
+  std::stringstream ls;
+  io::writeText(ls, L, {';'});
+  if (io::readText<Matrix<long double>>(ls) != L) {
+    throw make_tuple(allBenches.back(), L, ls.str());
+  }
+}
+
+void test_shared_storage(Index n, int cnt)
+{
+  SharedMatrix<double> A(n, n);
+  for (Index i = 0; i < A.size(); ++i) {
+    A[i] = double(i);
+  }
+  const SharedMatrix<double>& cA = A;
+  BENCH("m:shared_storage:copy", "copy a copy-on-write matrix, which only shares the coefficients", cnt,
+    for (int i = 0; i < cnt; ++i) {
+      SharedMatrix<double> B = A;
+      if (&static_cast<const SharedMatrix<double>&>(B)[0] != &cA[0]) {
+        throw allBenches.back();
+      }
+    }
+  )
+
+  SharedMatrix<double> B(1, 1);
+  B = A;  // shares and takes over the shape
+  const SharedMatrix<double>& cB = B;
+  if (B.rows() != n || &cB[0] != &cA[0]) {
+    throw make_tuple(allBenches.back(), B);
+  }
+  B(0, 1) = -1.0;  // detaches
+  if (&cB[0] == &cA[0] || A(0, 1) != 1.0 || B(0, 1) != -1.0 || B[2] != 2.0) {
+    throw make_tuple(allBenches.back(), A, B);
+  }
+
+  // a parallel kernel writing to a shared matrix detaches it once
+  const auto threads = parallel::numThreads();
+  parallel::setNumThreads(4);
+  SharedMatrix<double> C = A;
+  C.mulByScalar(2.0);
+  parallel::setNumThreads(threads);
+  if (A[5] != 5.0 || C[5] != 10.0 || C[A.size() - 1] != 2.0 * A[A.size() - 1]) {
+    throw make_tuple(allBenches.back(), A, C);
+  }
+
+  // two threads write to their own copies at once, each with a parallel kernel
+  parallel::setNumThreads(4);
+  const SharedMatrix<double> orig = A;
+  SharedMatrix<double> D1 = A;
+  SharedMatrix<double> D2 = A;
+  {
+    std::jthread t1([&D1] { D1.mulByScalar(-1.0); });
+    std::jthread t2([&D2] { D2.mulByScalar(3.0); });
+  }
+  parallel::setNumThreads(threads);
+  for (Index i = 0; i < A.size(); ++i) {
+    if (orig[i] != double(i) || D1[i] != -double(i) || D2[i] != 3.0 * double(i)) {
+      throw make_tuple(allBenches.back(), orig, D1, D2);
+    }
+  }
+}
+
+void test_structured_products(Index n, Index k)
+{
+  Matrix<double> A(n, k);
+  Matrix<double> B(n, 7);
+  for (Index i = 0; i < A.size(); ++i) {
+    uint64_t h = i * 6364136223846793005ULL + 1442695040888963407ULL;
+    A[i] = double((h ^ (h >> 33)) % 1000) / 500.0 - 1.0;
+  }
+  for (Index i = 0; i < B.size(); ++i) {
+    B[i] = double(i % 9) - 4.0;
+  }
+  const Matrix<double> At = A.transpose();
+  const auto threads = parallel::numThreads();
+  parallel::setNumThreads(4);
+
+  Matrix<double> C(n, n);
+  BENCH_FLOPS("m:structured:syrk", "A * A.transpose(), only the lower triangle is computed", 1, double(n * (n + 1) * k),
+    C = A * A.transpose();
+  )
+  const Matrix<double> Cref = A * At;
+  if (maxAbsDiff(C, Cref) > 1e-9 || C(0, n - 1) != C(n - 1, 0)) {
+    throw make_tuple(allBenches.back(), A, C);
+  }
+  if (maxAbsDiff(A.transpose() * A, At * A) > 1e-9) {
+    throw make_tuple(allBenches.back(), A);
+  }
+
+  // triangular and symmetric operands, the unread triangle holds garbage
+  Matrix<double> T = Cref;
+  Matrix<double> L = Matrix<double>::zeros(n, n);
+  Matrix<double> U = Matrix<double>::zeros(n, n);
+  Matrix<double> S(n, n);
+  for (Index i = 0; i < n; ++i) {
+    for (Index j = 0; j < n; ++j) {
+      (j <= i ? L : U)(i, j) = T(i, j);
+      S(i, j) = j <= i ? T(i, j) : 1e6;
+    }
+    U(i, i) = T(i, i);
+  }
+  Matrix<double> LU1 = L;
+  for (Index i = 0; i < n; ++i) {
+    LU1(i, i) = 1.0;
+  }
+  if (maxAbsDiff(triangularMultiply<UpLo::Lower>(T, B), L * B) > 1e-9
+    || maxAbsDiff(triangularMultiply<UpLo::Upper>(T, B), U * B) > 1e-9
+    || maxAbsDiff(triangularMultiply<UpLo::Lower, Diag::Unit>(T, B), LU1 * B) > 1e-9
+    || maxAbsDiff(symmetricMultiply<UpLo::Lower>(S, B), Cref * B) > 1e-9
+    || maxAbsDiff(symmetricMultiply<UpLo::Upper>(S.transpose().eval(), B), Cref * B) > 1e-9) {
+    throw make_tuple(allBenches.back(), T, B);
+  }
+
+  // the view evaluates before it overwrites its own matrix
+  Matrix<double> D = A * At;
+  D(0, 1) = 5.0;
+  D += D.transpose();
+  if (D(0, 1) != D(1, 0) || D(0, 1) != 5.0 + Cref(1, 0)) {
+    throw make_tuple(allBenches.back(), D);
+  }
+  parallel::setNumThreads(threads);
+
+  // assigning a view resizes dynamic matrices, also onto its own matrix
+  Matrix<double> E(2, 2);
+  E = A.transpose();
+  if (E.rows() != k || E.cols() != n || E != At) {
+    throw make_tuple(allBenches.back(), E);
+  }
+  E = E.transpose();
+  Matrix<double> F(3, 3);
+  F = A;
+  Matrix<double, -1, 3> G(1, 3);
+  G = Matrix<double>::ones(5, 3).transpose().transpose();
+  if (E != A || F != A || G.rows() != 5) {
+    throw make_tuple(allBenches.back(), E, F);
+  }
+  bool isThrown = false;
+  try {
+    G = A;  // the fixed dimension can't change
+  } catch (const std::runtime_error&) {
+    isThrown = true;
+  }
+  if (!isThrown) {
+    throw allBenches.back();
+  }
+  // the transpose of a temporary is a matrix, views are read-only
+  static_assert(is_same_v<decltype((A * At).transpose()), Matrix<double>>);
+  static_assert(!IsWritable<TransposeView<Matrix<double>>> && IsWritable<Matrix<double>>);
+}
+
+void test_matrix_vector(Index n, int cnt)
+{
+  const auto threads = parallel::numThreads();
+  parallel::setNumThreads(4);
+  for (Index m : {n, n / 7, 3 * n}) {
+    Matrix<double> A(n, m);
+    Matrix<double> x(m, 1);
+    Matrix<double> xr(1, n);
+    for (Index i = 0; i < A.size(); ++i) {
+      A[i] = double(i % 13) - 6.0;
+    }
+    for (Index i = 0; i < m; ++i) {
+      x[i] = double(i % 5) - 2.0;
+    }
+    for (Index i = 0; i < n; ++i) {
+      xr[i] = double(i % 3) - 1.0;
+    }
+    auto Ax = Matrix<double>::zeros(n, 1);
+    auto xA = Matrix<double>::zeros(1, m);
+    mul::multiplyMatrix<Index>(A, x, Ax);
+    mul::multiplyMatrix<Index>(xr, A, xA);
+
+    // beta == 0 must not read the garbage of y
+    Matrix<double> y = Matrix<double>::fill(n, 1, std::numeric_limits<double>::quiet_NaN());
+    BENCH_FLOPS("m:matrix_vector:gemv", "y = A * x into an existing y", cnt, 2.0 * double(n * m * cnt),
+      for (int i = 0; i < cnt; ++i) {
+        multiplyVector(A, x, y);
+      }
+    )
+    if (y != Ax || A * x != Ax || xr * A != xA) {
+      throw make_tuple(allBenches.back(), A, x, xr);
+    }
+    Matrix<double> yr = xA;
+    multiplyRowVector(xr, A, yr, 2.0, -1.0);
+    multiplyVector(A, x, y, -2.0, 3.0);
+    if (yr != xA || y != Ax) {
+      throw make_tuple(allBenches.back(), A, y, yr);
+    }
+  }
+  parallel::setNumThreads(threads);
+
+  bool isThrown = false;
+  try {
+    Matrix<double> A(3, 4);
+    Matrix<double> x(4, 1);
+    Matrix<double> y(4, 1);
+    multiplyVector(A, x, y);
+  } catch (const std::runtime_error&) {
+    isThrown = true;
+  }
+  if (!isThrown) {
+    throw allBenches.back();
+  }
+}
+
+void test_blas_backend(Index n)
+{
+  Matrix<double> A(n, n);
+  Matrix<double> B(n, n);
+  Matrix<double> x(n, 1);
+  Matrix<double> xr(1, n);
+  for (Index i = 0; i < A.size(); ++i) {
+    A[i] = double(i % 17) / 8.0 - 1.0;
+    B[i] = double(i % 11) / 5.0 - 1.0;
+  }
+  for (Index i = 0; i < n; ++i) {
+    x[i] = double(i % 3);
+    xr[i] = double(i % 7) - 3.0;
+  }
+  auto run = [&]
+  {
+    Matrix<double> C = B;
+    C += A;
+    C -= 2.0 * B;
+    C = C * 0.5;
+    return make_tuple(A * B, A * x, xr * A, C);
+  };
+  const bool useCblas = backend::useCblas();
+  const auto blasMinWork = tuning::params().blasMinWork;
+  backend::setUseCblas(false);
+  const auto builtIn = run();
+  backend::setUseCblas(true);
+  tuning::params().blasMinWork = 1;
+  decltype(run()) routed;
+  BENCH("m:backend:ops", backend::hasCblas ? "products and coefficient-wise ops through CBLAS" : "no CBLAS, built-in kernels", 1,
+    routed = run();
+  )
+  backend::setUseCblas(useCblas);
+  tuning::params().blasMinWork = blasMinWork;
+  if (maxAbsDiff(std::get<0>(builtIn), std::get<0>(routed)) > 1e-9
+    || maxAbsDiff(std::get<1>(builtIn), std::get<1>(routed)) > 1e-9
+    || maxAbsDiff(std::get<2>(builtIn), std::get<2>(routed)) > 1e-9
+    || maxAbsDiff(std::get<3>(builtIn), std::get<3>(routed)) > 1e-12) {
+    throw make_tuple(allBenches.back(), A, B);
+  }
+  // fixed dimensions and inline storages keep their own kernels
+  static_assert(backend::BlasMatrix<Matrix<double>> && backend::BlasMatrix<MatrixMap<double>>);
+  static_assert(!backend::BlasMatrix<Matrix<double, -1, 3>> && !backend::BlasMatrix<Matrix<double, 3, 3>>
+    && !backend::BlasMatrix<SmallMatrix<double>>);
+}
+
+void test_eigen_map(Index n)
+{
+  Matrix<double> A(n, n + 1);
+  for (Index i = 0; i < A.size(); ++i) {
+    A[i] = double(i);
+  }
+  // DistMat -> Eigen, the map writes into A
+  auto eA = toEigen(A);
+  if (eA.data() != &A(0, 0) || eA(1, 2) != A(1, 2)) {
+    throw make_tuple(allBenches.back(), A);
+  }
+  eA *= 2.0;
+  if (A(1, 2) != 2.0 * double(n + 1 + 2)) {
+    throw make_tuple(allBenches.back(), A);
+  }
+  Matrix<double, 3, 3> F = Matrix<double, 3, 3>::eye();
+  static_assert(decltype(toEigen(F))::RowsAtCompileTime == 3);
+  if (toEigen(F).trace() != 3.0) {
+    throw make_tuple(allBenches.back(), F);
+  }
+
+  // Eigen -> DistMat, results of the operators own their coefficients
+  Eigen::Matrix<double, -1, -1, Eigen::RowMajor> E = Eigen::Matrix<double, -1, -1, Eigen::RowMajor>::Ones(n + 1, n);
+  auto M = fromEigen(E);
+  M(0, 1) = 5.0;
+  if (E(0, 1) != 5.0 || &M(0, 0) != E.data()) {
+    throw make_tuple(allBenches.back(), M);
+  }
+  auto P = A * M;
+  static_assert(is_same_v<decltype(P), Matrix<double>>);
+  Eigen::MatrixXd eP = toEigen(A) * E;
+  for (Index i = 0; i < P.rows(); ++i) {
+    for (Index j = 0; j < P.cols(); ++j) {
+      if (std::abs(P(i, j) - eP(i, j)) > 1e-9) {
+        throw make_tuple(allBenches.back(), P);
+      }
+    }
+  }
+  M = Matrix<double>::zeros(n + 1, n);  // assignment writes through
+  if (E.squaredNorm() != 0.0) {
+    throw make_tuple(allBenches.back(), M);
+  }
+
+  Eigen::VectorXd v = Eigen::VectorXd::LinSpaced(n, 0.0, 1.0);
+  if (fromEigen(v).rows() != n || fromEigen(v)(n - 1, 0) != 1.0) {
+    throw allBenches.back();
+  }
+  Eigen::MatrixXd colMajor(2, 3);
+  bool isThrown = false;
+  try {
+    fromEigen(colMajor);
+  } catch (const std::runtime_error&) {
+    isThrown = true;
+  }
+  if (!isThrown) {
+    throw allBenches.back();
+  }
+}
+
 void test_unary_negate(int cnt)
 {
 }
 
+void test_random(Index n, int cnt)
+{
+  // known answers of Philox4x32-10 from the Random123 distribution
+  const rng::Philox4x32::Block zero = rng::Philox4x32(0)({0, 0, 0, 0});
+  const rng::Philox4x32::Block pi = rng::Philox4x32(0x299f31d0a4093822)({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344});
+  if (zero != rng::Philox4x32::Block{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}
+    || pi != rng::Philox4x32::Block{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}) {
+    throw allBenches.back();
+  }
+
+  // odd sizes leave a partial block at the end of the last chunk
+  const auto threads = parallel::numThreads();
+  parallel::setNumThreads(1);
+  const auto N1 = Matrix<double>::random(n, n + 3, rng::Normal<double>{1.0, 2.0}, 42);
+  const auto U1 = Matrix<float>::random(n + 1, n, rng::Uniform<float>{-1.0F, 1.0F}, 7);
+  parallel::setNumThreads(4);
+  Matrix<double> N4;
+  BENCH("m:random:normal", "normal coefficients with 4 threads", cnt,
+    for (int i = 0; i < cnt; ++i) {
+      N4 = Matrix<double>::random(n, n + 3, rng::Normal<double>{1.0, 2.0}, 42);
+    }
+  )
+  const auto U4 = Matrix<float>::random(n + 1, n, rng::Uniform<float>{-1.0F, 1.0F}, 7);
+  parallel::setNumThreads(threads);
+  if (N1 != N4 || U1 != U4 || Matrix<double>::random(n, n, {}, 1) == Matrix<double>::random(n, n, {}, 2)) {
+    throw make_tuple(allBenches.back(), N1, N4);
+  }
+
+  double mean = 0.0;
+  double var = 0.0;
+  for (Index i = 0; i < N1.size(); ++i) {
+    mean += N1[i];
+    var += (N1[i] - 1.0) * (N1[i] - 1.0);
+  }
+  mean /= double(N1.size());
+  var /= double(N1.size());
+  if (std::abs(mean - 1.0) > 0.05 || std::abs(var - 4.0) > 0.1) {
+    throw make_tuple(allBenches.back(), mean, var);
+  }
+  for (Index i = 0; i < U1.size(); ++i) {
+    if (U1[i] < -1.0F || U1[i] >= 1.0F) {
+      throw make_tuple(allBenches.back(), U1);
+    }
+  }
+  // the largest uniform number times (b - a) rounds up to b in [1, 2)
+  const rng::Philox4x32::Block ones{0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF};
+  float uf[4];
+  double ud[2];
+  rng::Uniform<float>{1.0F, 2.0F}(ones, uf);
+  rng::Uniform<double>{1.0, 2.0}(ones, ud);
+  if (uf[0] >= 2.0F || uf[0] < 1.0F || ud[1] >= 2.0 || ud[1] < 1.0) {
+    throw make_tuple(allBenches.back(), uf[0], ud[1]);
+  }
+  const auto U2 = Matrix<float>::random(n, n, rng::Uniform<float>{1.0F, 2.0F}, 9);
+  for (Index i = 0; i < U2.size(); ++i) {
+    if (U2[i] < 1.0F || U2[i] >= 2.0F) {
+      throw make_tuple(allBenches.back(), U2);
+    }
+  }
+  const auto D = Matrix<int>::random(n, n, rng::Uniform<int>{-3, 3}, 5);
+  vector<Index> histogram(7, 0);
+  for (Index i = 0; i < D.size(); ++i) {
+    if (D[i] < -3 || D[i] > 3) {
+      throw make_tuple(allBenches.back(), D);
+    }
+    ++histogram[D[i] + 3];
+  }
+  for (Index count : histogram) {
+    if (std::abs(double(count) / double(D.size()) - 1.0 / 7.0) > 0.01) {
+      throw make_tuple(allBenches.back(), D);
+    }
+  }
+}
+
+/// `||A * x - b|| / ||b||`
+double relativeResidual(const Matrix<double>& A, const Matrix<double>& x, const Matrix<double>& b)
+{
+  Matrix<double> r = b;
+  multiplyVector(A, x, r, 1.0, -1.0);
+  double rr = 0.0;
+  double bb = 0.0;
+  for (Index i = 0; i < b.size(); ++i) {
+    rr += r[i] * r[i];
+    bb += b[i] * b[i];
+  }
+  return std::sqrt(rr / bb);
+}
+
+void test_iterative_solvers(Index n, int cnt)
+{
+  // badly scaled symmetric positive definite, which Jacobi fixes
+  const auto B = Matrix<double>::random(n, n, rng::Uniform<double>{-1.0, 1.0}, 3);
+  Matrix<double> A = transposedMultiply(B);
+  for (Index i = 0; i < n; ++i) {
+    A(i, i) += double(n);
+  }
+  for (Index i = 0; i < n; ++i) {
+    for (Index j = 0; j < n; ++j) {
+      A(i, j) *= double(1 + i % 10) * double(1 + j % 10);
+    }
+  }
+  const auto b = Matrix<double>::random(n, 1, rng::Uniform<double>{-1.0, 1.0}, 4);
+
+  const auto threads = parallel::numThreads();
+  parallel::setNumThreads(4);
+  ConjugateGradient<double> cg(n);
+  Matrix<double> x(n, 1);
+  iterative::Info info;
+  BENCH("m:iterative:cg", "conjugate gradient from x = 0 with 4 threads", cnt,
+    for (int i = 0; i < cnt; ++i) {
+      x = Matrix<double>::zeros(n, 1);
+      info = cg.solve(A, b, x);
+    }
+  )
+  if (!info.converged || relativeResidual(A, x, b) > 1e-8) {
+    throw make_tuple(allBenches.back(), info.iterations, info.residual);
+  }
+  const iterative::JacobiPreconditioner<double> jacobi(A);
+  Matrix<double> xp = Matrix<double>::zeros(n, 1);
+  const auto pinfo = cg.solve(A, b, xp, jacobi);
+  if (!pinfo.converged || pinfo.iterations >= info.iterations || relativeResidual(A, xp, b) > 1e-8) {
+    throw make_tuple(allBenches.back(), pinfo.iterations, info.iterations);
+  }
+  parallel::setNumThreads(threads);
+
+  // any preconditioner with `apply` goes through the unfused path
+  struct Scaled {
+    const iterative::JacobiPreconditioner<double>& jacobi;
+    void apply(const Matrix<double>& r, Matrix<double>& z) const { jacobi.apply(r, z); }
+  };
+  Matrix<double> xg = Matrix<double>::zeros(n, 1);
+  const auto ginfo = cg.solve(A, b, xg, Scaled{jacobi});
+  if (!ginfo.converged || ginfo.iterations > pinfo.iterations + 1 || pinfo.iterations > ginfo.iterations + 1 || relativeResidual(A, xg, b) > 1e-8) {
+    throw make_tuple(allBenches.back(), ginfo.iterations, pinfo.iterations);
+  }
+
+  // non symmetric, diagonally dominant
+  Matrix<double> C = Matrix<double>::random(n, n, rng::Uniform<double>{-1.0, 1.0}, 5);
+  for (Index i = 0; i < n; ++i) {
+    C(i, i) = double(n) * double(1 + i % 7);
+  }
+  BiCGSTAB<double> bicgstab;
+  for (unsigned t : {1U, 4U}) {
+    parallel::setNumThreads(t);
+    Matrix<double> y = Matrix<double>::zeros(n, 1);
+    Matrix<double> yp = Matrix<double>::zeros(n, 1);
+    Matrix<double> yg = Matrix<double>::zeros(n, 1);
+    const auto binfo = bicgstab.solve(C, b, y);
+    const auto bpinfo = bicgstab.solve(C, b, yp, iterative::JacobiPreconditioner<double>(C));
+    const auto bginfo = bicgstab.solve(C, b, yg, Scaled{iterative::JacobiPreconditioner<double>(C)});
+    if (!binfo.converged || !bpinfo.converged || !bginfo.converged || relativeResidual(C, y, b) > 1e-8
+      || relativeResidual(C, yp, b) > 1e-8 || relativeResidual(C, yg, b) > 1e-8) {
+      throw make_tuple(allBenches.back(), binfo.iterations, bpinfo.iterations, bginfo.iterations);
+    }
+  }
+  parallel::setNumThreads(threads);
+
+  // matrix-free 1-D Laplacian
+  const Index m = 3 * n;
+  auto laplacian = [m](const Matrix<double>& in, Matrix<double>& out)
+  {
+    for (Index i = 0; i < m; ++i) {
+      out[i] = 2.0 * in[i] - (i > 0 ? in[i - 1] : 0.0) - (i + 1 < m ? in[i + 1] : 0.0);
+    }
+  };
+  auto L = Matrix<double>::zeros(m, m);
+  for (Index i = 0; i < m; ++i) {
+    L(i, i) = 2.0;
+    if (i + 1 < m) {
+      L(i, i + 1) = L(i + 1, i) = -1.0;
+    }
+  }
+  const auto f = Matrix<double>::ones(m, 1);
+  Matrix<double> u = Matrix<double>::zeros(m, 1);
+  ConjugateGradient<double> laplacianCg(0, {1e-10, 2 * m});
+  const auto linfo = laplacianCg.solve(laplacian, f, u);
+  if (!linfo.converged || linfo.iterations > m || relativeResidual(L, u, f) > 1e-8) {
+    throw make_tuple(allBenches.back(), linfo.iterations, linfo.residual);
+  }
+  u = Matrix<double>::zeros(m, 1);
+  const auto halves = iterative::JacobiPreconditioner<double>::fromInverseDiagonal(Matrix<double>::fill(m, 1, 0.5));
+  if (!laplacianCg.solve(laplacian, f, u, halves).converged || relativeResidual(L, u, f) > 1e-8) {
+    throw make_tuple(allBenches.back(), u);
+  }
+  u = Matrix<double>::zeros(m, 1);
+  if (!bicgstab.solve(laplacian, f, u).converged || relativeResidual(L, u, f) > 1e-8) {
+    throw make_tuple(allBenches.back(), u);
+  }
+
+  // b = 0 has the solution x = 0
+  u = Matrix<double>::ones(m, 1);
+  if (!laplacianCg.solve(laplacian, Matrix<double>::zeros(m, 1), u).converged || u != Matrix<double>::zeros(m, 1)) {
+    throw make_tuple(allBenches.back(), u);
+  }
+
+  bool isThrown = false;
+  try {
+    Matrix<double> z(n + 1, 1);
+    cg.solve(A, b, z);
+  } catch (const std::runtime_error&) {
+    isThrown = true;
+  }
+  if (!isThrown) {
+    throw allBenches.back();
+  }
+
+  // an inverse diagonal of another length is rejected, not read out of bounds
+  const auto shortDiagonal = iterative::JacobiPreconditioner<double>::fromInverseDiagonal(Matrix<double>::fill(m - 1, 1, 0.5));
+  int thrown = 0;
+  for (int solver = 0; solver < 2; ++solver) {
+    try {
+      u = Matrix<double>::zeros(m, 1);
+      if (solver == 0) {
+        laplacianCg.solve(laplacian, f, u, shortDiagonal);
+      } else {
+        bicgstab.solve(laplacian, f, u, shortDiagonal);
+      }
+    } catch (const std::runtime_error&) {
+      ++thrown;
+    }
+  }
+  if (thrown != 2) {
+    throw make_tuple(allBenches.back(), thrown);
+  }
+}
+
 int main(int argc, char const *argv[])
 {
+  // run with the default parameters, not with a profile of this machine
+  setenv("DISTMAT_TUNING_PROFILE", "", 1);
+
   int* p = new int; // NOLINT
   cout << *p << endl; // NOLINT
   p = new int[10000000]; // NOLINT
@@ -129,6 +1045,22 @@ int main(int argc, char const *argv[])
   test_sub_eq_mul(A, 10);
   test_at_vs_operator_paren(B, 1000 * 1000);
   test_default_init(1000);
+  test_lu_solve(300);
+  test_llt(200);
+  test_pow(1000);
+  test_numa_policy(1000);
+  test_bench_counters();
+  test_autotune();
+  test_partially_fixed(100000, 10);
+  test_small_storage(100000);
+  test_text_io(100000);
+  test_shared_storage(1000, 1000);
+  test_structured_products(300, 200);
+  test_matrix_vector(700, 10);
+  test_blas_backend(200);
+  test_eigen_map(50);
+  test_random(500, 10);
+  test_iterative_solvers(300, 10);
 
   cout << A(0, 0) << endl;
   cout << A(0, 2) << endl;